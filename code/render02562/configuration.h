@@ -0,0 +1,9 @@
+#ifndef CONFIGURATIOM_H
+#define CONFIGURATIOM_H
+
+#include <string>
+
+std::string const models_path = "/root/repo/code/render02562/models/";
+
+//CONFIGURATIOM_H
+#endif
@@ -10,13 +10,14 @@
 
 struct AccObj
 {
-  AccObj() : geometry(0), prim_idx(0) { }
-  AccObj(Object3D* object, unsigned int primitive_idx) 
-    : geometry(object), prim_idx(primitive_idx), bbox(object->get_primitive_bbox(primitive_idx))
+  AccObj() : geometry(0), prim_idx(0), acc_idx(0) { }
+  AccObj(Object3D* object, unsigned int primitive_idx, unsigned int accelerator_idx = 0) 
+    : geometry(object), prim_idx(primitive_idx), acc_idx(accelerator_idx), bbox(object->get_primitive_bbox(primitive_idx))
   { }
 
   Object3D* geometry;
   unsigned int prim_idx;
+  unsigned int acc_idx;   // index in the primitive array of the accelerator
   optix::Aabb bbox;
 };
 
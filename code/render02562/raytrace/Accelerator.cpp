@@ -8,26 +8,28 @@
 #include "Object3D.h"
 #include "Plane.h"
 #include "HitInfo.h"
+#include "RenderStats.h"
 #include "Accelerator.h"
 
 using namespace std;
 using namespace optix;
 
 Accelerator::~Accelerator()
-{
-    for(unsigned int i = 0; i < primitives.size(); ++i)
-        delete primitives[i];
-}
+{ }
 
 void Accelerator::init(const vector<Object3D*>& geometry, const vector<const Plane*>& scene_planes)
 {
+    // Primitives are stored by value in one contiguous array
+    unsigned int no_of_prims = 0;
+    for(unsigned int i = 0; i < geometry.size(); ++i)
+        no_of_prims += geometry[i]->get_no_of_primitives();
+    primitives.clear();
+    primitives.reserve(no_of_prims);
     for(unsigned int i = 0; i < geometry.size(); ++i)
     {
         Object3D* obj = geometry[i];
-        unsigned int no_of_prims = primitives.size();
-        primitives.resize(no_of_prims + obj->get_no_of_primitives());
         for(unsigned int j = 0; j < obj->get_no_of_primitives(); ++j)
-            primitives[j + no_of_prims] = new AccObj(obj, j);
+            primitives.push_back(AccObj(obj, j, primitives.size()));
     }
     planes = scene_planes;
 }
@@ -51,9 +53,10 @@ bool Accelerator::closest_hit(optix::Ray& r, HitInfo& hit) const
     // Hint: Call the intersect(...) function for each primitive object in
     //       the scene. See the functions below this one for inspiration.
 
+    render_stats.add(RenderStats::primitives_tested, primitives.size());
     for (uint i = 0; i < primitives.size(); i++) {
-        AccObj* obj = primitives[i];
-        if (obj->geometry->intersect(r, hit, obj->prim_idx)) {
+        const AccObj& obj = primitives[i];
+        if (obj.geometry->intersect(r, hit, obj.prim_idx)) {
             r.tmax = hit.dist;
         }
     }
@@ -68,9 +71,10 @@ bool Accelerator::any_hit(optix::Ray& r, HitInfo& hit) const
         unsigned int i = 0;
         while(i < primitives.size() && !hit.has_hit)
         {
-            AccObj* obj = primitives[i++];
-            obj->geometry->intersect(r, hit, obj->prim_idx);
+            const AccObj& obj = primitives[i++];
+            obj.geometry->intersect(r, hit, obj.prim_idx);
         }
+        render_stats.add(RenderStats::primitives_tested, i);
     }
     return hit.has_hit;
 }
@@ -24,7 +24,7 @@ protected:
   void closest_plane(optix::Ray& r, HitInfo& hit) const;
   bool any_plane(optix::Ray& r, HitInfo& hit) const;
 
-  std::vector<AccObj*> primitives;
+  std::vector<AccObj> primitives;
   std::vector<const Plane*> planes;
 };
 
@@ -0,0 +1,65 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include "AliasTable.h"
+
+using namespace std;
+
+void AliasTable::build(const vector<float>& weights)
+{
+  unsigned int n = weights.size();
+  bins.resize(n);
+  pdf.resize(n);
+  if(n == 0)
+    return;
+
+  double sum = 0.0;
+  for(unsigned int i = 0; i < n; ++i)
+    sum += weights[i] > 0.0f ? weights[i] : 0.0f;
+
+  // Scale the probabilities so that the average bin holds exactly one
+  vector<double> scaled(n);
+  vector<unsigned int> small, large;
+  small.reserve(n);
+  large.reserve(n);
+  for(unsigned int i = 0; i < n; ++i)
+  {
+    double p = sum > 0.0 ? (weights[i] > 0.0f ? weights[i] : 0.0f)/sum : 1.0/n;
+    pdf[i] = static_cast<float>(p);
+    scaled[i] = p*n;
+    if(scaled[i] < 1.0)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+
+  // Fill each under-full bin with the remainder from an over-full one
+  while(!small.empty() && !large.empty())
+  {
+    unsigned int s = small.back();
+    unsigned int l = large.back();
+    small.pop_back();
+    large.pop_back();
+    bins[s].prob = static_cast<float>(scaled[s]);
+    bins[s].alias = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if(scaled[l] < 1.0)
+      small.push_back(l);
+    else
+      large.push_back(l);
+  }
+
+  // Remaining bins are full up to round-off
+  for(unsigned int i = 0; i < large.size(); ++i)
+  {
+    bins[large[i]].prob = 1.0f;
+    bins[large[i]].alias = large[i];
+  }
+  for(unsigned int i = 0; i < small.size(); ++i)
+  {
+    bins[small[i]].prob = 1.0f;
+    bins[small[i]].alias = small[i];
+  }
+}
@@ -0,0 +1,46 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef ALIASTABLE_H
+#define ALIASTABLE_H
+
+#include <vector>
+
+/** Walker's alias method (with Vose's construction) for drawing indices
+    with probabilities proportional to a set of non-negative weights in
+    constant time. If all weights are zero, indices are drawn uniformly. */
+class AliasTable
+{
+public:
+  void build(const std::vector<float>& weights);
+  void clear() { bins.clear(); pdf.clear(); }
+
+  /// Draw an index using a random number in [0,1)
+  unsigned int sample(double xi) const
+  {
+    double u = xi*bins.size();
+    unsigned int i = static_cast<unsigned int>(u);
+    if(i >= bins.size())
+      i = bins.size() - 1;
+    return u - i < bins[i].prob ? i : bins[i].alias;
+  }
+
+  /// Probability of drawing index i
+  float prob(unsigned int i) const { return pdf[i]; }
+
+  unsigned int size() const { return bins.size(); }
+  bool empty() const { return bins.empty(); }
+
+private:
+  struct Bin
+  {
+    float prob;
+    unsigned int alias;
+  };
+
+  std::vector<Bin> bins;
+  std::vector<float> pdf;
+};
+
+#endif // ALIASTABLE_H
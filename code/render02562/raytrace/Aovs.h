@@ -0,0 +1,21 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef AOVS_H
+#define AOVS_H
+
+#include <optix_world.h>
+
+/// Auxiliary per-pixel outputs (arbitrary output variables) of the first 
+/// hits in a pixel. They are averages over the samples in the pixel, and 
+/// they are what a denoiser needs besides the noisy color.
+struct Aovs
+{
+  optix::float3 albedo;  // Reflectance at the first hit (background color for misses)
+  optix::float3 normal;  // World space shading normal (zero for misses)
+  float depth;           // Distance along the ray to the first hit (0 if nothing was hit)
+  float samples;         // Number of samples taken in the pixel
+};
+
+#endif // AOVS_H
@@ -6,7 +6,6 @@
 #include "IndexedFaceSet.h"
 #include "ObjMaterial.h"
 #include "mt_random.h"
-#include "cdf_bsearch.h"
 #include "HitInfo.h"
 #include "AreaLight.h"
 #include <stdio.h>
@@ -86,18 +85,114 @@ bool AreaLight::emit(Ray& r, HitInfo& hit, float3& Phi) const
     // r.origin            (starting position of ray)
     // r.direction         (direction of ray)
 
-    // Get geometry info
-    const IndexedFaceSet& geometry = mesh->geometry;
-    const IndexedFaceSet& normals = mesh->normals;
-    const float no_of_faces = static_cast<float>(geometry.no_faces());
+    if(mesh->surface_area <= 0.0f)
+        return false;
 
     // Sample ray origin and direction
+    unsigned int triangle_id;
+    float v, w;
+    float3 origin = sample_position(triangle_id, v, w);
+    float3 dir;
+    cosine_sample_hemisphere(static_cast<float>(mt_random()), static_cast<float>(mt_random()), dir);
+    Onb onb(get_emitting_normal(triangle_id, v, w));
+    onb.inverse_transform(dir);
 
     // Trace ray
+    r = Ray(origin, dir, 0, 1.0e-4f, RT_DEFAULT_MAX);
+    if(!tracer->trace_to_closest(r, hit))
+        return false;
+
+    // If a surface was hit, compute Phi and return true.
+    // Area and cosine weighted direction sampling leaves pi times area times radiance.
+    Phi = get_emission(triangle_id)*mesh->surface_area*M_PIf;
+    return true;
+}
+
+bool AreaLight::sample_solid_angle(const float3& pos, float3& dir, float3& L, float& pdf) const
+{
+    L = make_float3(0.0f);
+    pdf = 0.0f;
+    if(mesh->surface_area <= 0.0f)
+        return false;
+
+    unsigned int triangle_id;
+    float v, w;
+    float3 light_pos = sample_position(triangle_id, v, w);
 
-    // If a surface was hit, compute Phi and return true
+    dir = light_pos - pos;
+    float sqr_dist = dot(dir, dir);
+    float dist = sqrt(sqr_dist);
+    dir /= dist;
 
-    return false;
+    // The light only emits on the side its normal points to
+    float cos_theta_l = -dot(dir, get_emitting_normal(triangle_id, v, w));
+    if(cos_theta_l <= 0.0f)
+        return false;
+
+    Ray shadow_ray(pos, dir, 0, 1.0e-4f, dist - 1.0e-4f);
+    HitInfo hit;
+    if(shadows && tracer->trace_to_any(shadow_ray, hit))
+        return false;
+
+    // Convert the area density 1/A to a solid angle density
+    pdf = sqr_dist/(cos_theta_l*mesh->surface_area);
+    L = get_emission(triangle_id);
+    return true;
+}
+
+bool AreaLight::eval_solid_angle(const float3& pos, const float3& dir, float3& L, float& pdf) const
+{
+    L = make_float3(0.0f);
+    pdf = 0.0f;
+    if(mesh->surface_area <= 0.0f)
+        return false;
+
+    // Find the closest triangle of the light source in the direction dir
+    Ray r(pos, dir, 0, 1.0e-4f, RT_DEFAULT_MAX);
+    HitInfo hit;
+    if(!light_bvh.closest_hit(r, hit))
+        return false;
+    mesh->compute_hit_attributes(r, hit);
+    unsigned int triangle_id = hit.prim_idx;
+
+    float3 normal = hit.geometric_normal;
+    if(dot(normal, hit.shading_normal) < 0.0f)
+        normal = -normal;
+    float cos_theta_l = -dot(dir, normal);
+    if(cos_theta_l <= 0.0f)
+        return false;
+
+    Ray shadow_ray(pos, dir, 0, 1.0e-4f, hit.dist - 1.0e-4f);
+    HitInfo shadow_hit;
+    if(shadows && tracer->trace_to_any(shadow_ray, shadow_hit))
+        return false;
+
+    pdf = hit.dist*hit.dist/(cos_theta_l*mesh->surface_area);
+    L = get_emission(triangle_id);
+    return true;
+}
+
+float3 AreaLight::sample_position(unsigned int& triangle_id, float& v, float& w) const
+{
+    // Choose a triangle according to area and a uniformly distributed point in it
+    triangle_id = mesh->sample_face(mt_random_half_open());
+    float sqrt_xi1 = sqrt(static_cast<float>(mt_random()));
+    float xi2 = static_cast<float>(mt_random());
+    v = sqrt_xi1*(1.0f - xi2);
+    w = sqrt_xi1*xi2;
+    const uint3& face = mesh->geometry.face(triangle_id);
+    return (1.0f - v - w)*mesh->geometry.vertex(face.x)
+           + v*mesh->geometry.vertex(face.y)
+           + w*mesh->geometry.vertex(face.z);
+}
+
+float3 AreaLight::get_power() const
+{
+    // Diffuse emitters: the power of a triangle is pi times its area times its radiance
+    float3 power = make_float3(0.0f);
+    for(unsigned int i = 0; i < mesh->geometry.no_faces(); ++i)
+        power += mesh->face_areas[i]*get_emission(i);
+    return power*M_PIf;
 }
 
 float3 AreaLight::get_emission(unsigned int triangle_id) const
@@ -106,6 +201,24 @@ float3 AreaLight::get_emission(unsigned int triangle_id) const
     return make_float3(mat.ambient[0], mat.ambient[1], mat.ambient[2]);
 }
 
+float3 AreaLight::get_emitting_normal(unsigned int triangle_id, float v, float w) const
+{
+    // Geometric normal oriented to agree with the interpolated vertex normal
+    const uint3& face = mesh->geometry.face(triangle_id);
+    const float3& p0 = mesh->geometry.vertex(face.x);
+    float3 normal = normalize(cross(mesh->geometry.vertex(face.y) - p0, mesh->geometry.vertex(face.z) - p0));
+    if(mesh->has_normals())
+    {
+        const uint3& n_face = mesh->normals.face(triangle_id);
+        float3 shading_normal = (1.0f - v - w)*mesh->normals.vertex(n_face.x)
+                                + v*mesh->normals.vertex(n_face.y)
+                                + w*mesh->normals.vertex(n_face.z);
+        if(dot(normal, shading_normal) < 0.0f)
+            normal = -normal;
+    }
+    return normal;
+}
+
 
 //bool AreaLight::sample(const float3& pos, float3& dir, float3& L) const
 //{
@@ -5,8 +5,10 @@
 #ifndef AREALIGHT_H
 #define AREALIGHT_H
 
+#include <vector>
 #include <optix_world.h>
 #include "TriMesh.h"
+#include "Bvh.h"
 #include "RayTracer.h"
 #include "HitInfo.h"
 #include "Light.h"
@@ -14,17 +16,30 @@
 class AreaLight : public Light
 {
 public:
-  AreaLight(RayTracer* ray_tracer, const TriMesh* triangle_mesh, unsigned int no_of_samples = 1) 
+  AreaLight(RayTracer* ray_tracer, TriMesh* triangle_mesh, unsigned int no_of_samples = 1) 
     : Light(ray_tracer, no_of_samples), mesh(triangle_mesh)
-  { }
+  { 
+    // Tree used to find the light triangle in a direction (for MIS weights)
+    light_bvh.init(std::vector<Object3D*>(1, triangle_mesh), std::vector<const Plane*>());
+  }
 
   virtual bool sample(const optix::float3& pos, optix::float3& dir, optix::float3& L) const;
   virtual bool emit(optix::Ray& r, HitInfo& hit, optix::float3& Phi) const;
+  virtual bool sample_solid_angle(const optix::float3& pos, optix::float3& dir, optix::float3& L, float& pdf) const;
+  virtual bool eval_solid_angle(const optix::float3& pos, const optix::float3& dir, optix::float3& L, float& pdf) const;
+  virtual bool has_area() const { return true; }
+  virtual optix::float3 get_power() const;
+
+  // Update the light tree after the vertices of the light mesh have moved
+  void refit() { light_bvh.refit(); }
 
 protected:
   optix::float3 get_emission(unsigned int triangle_id) const;
+  optix::float3 get_emitting_normal(unsigned int triangle_id, float v, float w) const;
+  optix::float3 sample_position(unsigned int& triangle_id, float& v, float& w) const;
 
   const TriMesh* mesh;
+  Bvh light_bvh;
 };
 
 #endif // AREALIGHT_H
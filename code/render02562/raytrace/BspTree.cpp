@@ -4,11 +4,18 @@
 // This file written by Jeppe Revall Frisvad, 2011
 // Copyright (c) DTU Informatics 2011
 
+#include <iostream>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <optix_world.h>
 #include "AccObj.h"
 #include "Object3D.h"
 #include "HitInfo.h"
+#include "MappedFile.h"
+#include "RenderStats.h"
+#include "fnv_hash.h"
+#include "binary_io.h"
 #include "BspTree.h"
 
 using namespace std;
@@ -18,21 +25,55 @@ namespace
 {
     const float f_eps = 1.0e-6f;
     const float d_eps = 1.0e-12f;
+
+    // Bump the version whenever the tree layout or the build changes
+    const char cache_magic[8] = { '0', '2', '5', '6', '2', 'B', 'S', 'P' };
+    const unsigned int cache_version = 1;
+
+    struct CacheHeader
+    {
+        char magic[8];
+        unsigned int version;
+        unsigned int no_of_nodes;
+        unsigned long long key;
+        unsigned int no_of_tree_objects;
+        unsigned int padding;
+    };
 }
 
 BspTree::~BspTree()
 {
-    delete_node(root);
+    delete cache;
 }
 
 void BspTree::init(const vector<Object3D*>& geometry, const std::vector<const Plane*>& scene_planes)
 {
-    root = new BspNode;
     Accelerator::init(geometry, scene_planes);
     for(unsigned int i = 0; i < geometry.size(); ++i)
         bbox.include(geometry[i]->compute_bbox());
-    vector<AccObj*> objects = primitives;
-    subdivide_node(*root, bbox, 0, objects);
+
+    // Use a previously built tree if the geometry and build parameters are the same
+    unsigned long long key = 0;
+    if(!cache_file.empty())
+    {
+        key = compute_cache_key();
+        if(load_cache(cache_file, key))
+        {
+            cout << "Loaded BSP tree from " << cache_file << endl;
+            return;
+        }
+    }
+
+    vector<unsigned int> objects(primitives.size());
+    for(unsigned int i = 0; i < objects.size(); ++i)
+        objects[i] = i;
+    node_storage.resize(1);
+    subdivide_node(0, bbox, 0, objects);
+    nodes = &node_storage[0];
+    tree_objects = tree_object_storage.empty() ? 0 : &tree_object_storage[0];
+
+    if(!cache_file.empty())
+        save_cache(cache_file, key);
 }
 
 bool BspTree::closest_hit(Ray& r, HitInfo& hit) const
@@ -47,7 +88,7 @@ bool BspTree::closest_hit(Ray& r, HitInfo& hit) const
     // Test with biggest bounding box first
     if (intersect_min_max(r)) {
         // Start at the root
-        BspNode root = *this->root;
+        const BspNode& root = nodes[0];
         intersect_node(r, hit, root);
     }
     return hit.has_hit;
@@ -69,7 +110,7 @@ bool BspTree::any_hit(Ray& r, HitInfo& hit) const
         return false;
     }
     // Start at the root
-    BspNode root = *this->root;
+    const BspNode& root = nodes[0];
     return intersect_node(r, hit, root);
 }
 
@@ -88,28 +129,29 @@ bool BspTree::intersect_min_max(Ray& r) const
     return true;
 }
 
-void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vector<AccObj*>& objects)
+void BspTree::subdivide_node(unsigned int node_idx, Aabb& bbox, unsigned int level, vector<unsigned int>& objects)
 {
     const int TESTS = 4;
 
     // This is a recursive function building the BSP tree.
     //
-    // Input:  node            (the node to be subdivided if it does not fulfil a stop criterion)
+    // Input:  node_idx        (index of the node to be subdivided if it does not fulfil a stop criterion)
     //         bbox            (bounding box of the geometry to be stored in the node)
     //         level           (subdivision level of the node)
-    //         objects         (array of pointers to primitive objects)
+    //         objects         (array of indices of primitive objects)
     //
     // Output: node.axis_leaf  (flag signalling if the node is a leaf or which axis it was split in, always set)
     //         node.plane      (displacement along the axis of the splitting plane, set if not leaf)
-    //         node.left       (pointer to the left node in the next level of the tree, set if not leaf)
-    //         node.right      (pointer to the right node in the next level of the tree, set if not leaf)
+    //         node.left       (index of the left node in the next level of the tree, set if not leaf)
+    //         node.right      (index of the right node in the next level of the tree, set if not leaf)
     //         node.id         (index pointing to the primitive objects associated with the node, set if leaf)
     //         node.count      (number of primitive objects associated with the node, set if leaf)
     //
     // Relevant data fields that are available (see BspTree.h)
     // max_objects             (maximum number of primitive objects in a leaf, stop criterion)
     // max_level               (maximum subdivision level, stop criterion)
-    // tree_objects            (array for storing primitive objects associated with leaves)
+    // node_storage            (array of tree nodes, children are appended)
+    // tree_object_storage     (array for storing indices of primitive objects associated with leaves)
     //
     //
     // Hint: Finding a good way of positioning the splitting planes is hard.
@@ -120,24 +162,28 @@ void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vect
     //       to estimate the cost of a particular plane position. After all the
     //       tests, use the plane position with minimum cost.
 
+    // Children are appended to node_storage, so the node is filled in
+    // locally and stored before the recursive calls.
+    BspNode node;
     if(objects.size() <= max_objects || level == max_level)
     {
         node.axis_leaf = bsp_leaf; // Means that this is a leaf
-        node.id = tree_objects.size();
+        node.id = tree_object_storage.size();
         node.count = objects.size();
 
-        tree_objects.resize(tree_objects.size() + objects.size());
+        tree_object_storage.resize(tree_object_storage.size() + objects.size());
         for(unsigned int i = 0; i < objects.size(); ++i)
-            tree_objects[node.id + i] = objects[i];
+            tree_object_storage[node.id + i] = primitives[objects[i]].acc_idx;
+        node_storage[node_idx] = node;
     }
     else
     {
         Aabb left_bbox = bbox;
         Aabb right_bbox = bbox;
-        vector<AccObj*> left_objects;
-        vector<AccObj*> right_objects;
-        node.left = new BspNode;
-        node.right = new BspNode;
+        vector<unsigned int> left_objects;
+        vector<unsigned int> right_objects;
+        unsigned int best_left_count = 0;
+        unsigned int best_right_count = 0;
 
         double min_cost = 1.0e27;
         for(unsigned int i = 0; i < 3; ++i)
@@ -159,9 +205,9 @@ void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vect
                 unsigned int right_count = 0;
                 for(unsigned int j = 0; j < objects.size(); ++j)
                 {
-                    AccObj* obj = objects[j];
-                    left_count += left_bbox.intersects(obj->bbox);
-                    right_count += right_bbox.intersects(obj->bbox);
+                    const Aabb& obj_bbox = primitives[objects[j]].bbox;
+                    left_count += left_bbox.intersects(obj_bbox);
+                    right_count += right_bbox.intersects(obj_bbox);
                 }
 
                 double cost = left_count*left_bbox.area() + right_count*right_bbox.area();
@@ -170,8 +216,8 @@ void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vect
                     min_cost = cost;
                     node.axis_leaf = static_cast<BspNodeType>(i);
                     node.plane = center;
-                    node.left->count = left_count;
-                    node.right->count = right_count;
+                    best_left_count = left_count;
+                    best_right_count = right_count;
                 }
             }
         }
@@ -183,27 +229,27 @@ void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vect
         float center = node.plane;
         float diff = f_eps < size/8.0f ? size/8.0f : f_eps;
 
-        if(node.left->count == 0)
+        if(best_left_count == 0)
         {
             // Find min position of all triangle vertices and place the center there
             center = max_corner;
             for(unsigned int j = 0; j < objects.size(); ++j)
             {
-                AccObj* obj = objects[j];
-                float obj_min_corner = *(&obj->bbox.m_min.x + node.axis_leaf);
+                const Aabb& obj_bbox = primitives[objects[j]].bbox;
+                float obj_min_corner = *(&obj_bbox.m_min.x + node.axis_leaf);
                 if(obj_min_corner < center)
                     center = obj_min_corner;
             }
             center -= diff;
         }
-        if(node.right->count == 0)
+        if(best_right_count == 0)
         {
             // Find max position of all triangle vertices and place the center there
             center = min_corner;
             for(unsigned int j = 0; j<objects.size(); ++j)
             {
-                AccObj* obj = objects[j];
-                float obj_max_corner = *(&obj->bbox.m_max.x + node.axis_leaf);
+                const Aabb& obj_bbox = primitives[objects[j]].bbox;
+                float obj_max_corner = *(&obj_bbox.m_max.x + node.axis_leaf);
                 if(obj_max_corner > center)
                     center = obj_max_corner;
             }
@@ -219,16 +265,20 @@ void BspTree::subdivide_node(BspNode& node, Aabb& bbox, unsigned int level, vect
         // Now put the triangles in the right and left node
         for(unsigned int i = 0; i < objects.size(); ++i)
         {
-            AccObj* obj = objects[i];
-            if(left_bbox.intersects(obj->bbox))
-                left_objects.push_back(obj);
-            if(right_bbox.intersects(obj->bbox))
-                right_objects.push_back(obj);
+            const Aabb& obj_bbox = primitives[objects[i]].bbox;
+            if(left_bbox.intersects(obj_bbox))
+                left_objects.push_back(objects[i]);
+            if(right_bbox.intersects(obj_bbox))
+                right_objects.push_back(objects[i]);
         }
 
-        objects.clear();
-        subdivide_node(*node.left, left_bbox, level + 1, left_objects);
-        subdivide_node(*node.right, right_bbox, level + 1, right_objects);
+        vector<unsigned int>().swap(objects); // release memory before recursing
+        node.left = node_storage.size();
+        node.right = node.left + 1;
+        node_storage.resize(node_storage.size() + 2);
+        node_storage[node_idx] = node;
+        subdivide_node(node.left, left_bbox, level + 1, left_objects);
+        subdivide_node(node.right, right_bbox, level + 1, right_objects);
     }
 }
 
@@ -245,20 +295,23 @@ bool BspTree::intersect_node(Ray& ray, HitInfo& hit, const BspNode& node) const
     //         hit       (hit info retrieved from primitive intersection function)
     //
     // Relevant data fields that are available (see BspTree.h)
-    // tree_objects      (array of primitive objects associated with leaves)
+    // nodes             (array of tree nodes)
+    // tree_objects      (array of indices of primitive objects associated with leaves)
     //
     //
     // Hint: Stop the recursion once a leaf node has been found and get
     //       access to the intersect function of a primitive object through
     //       the geometry field.
 
+    render_stats.add(RenderStats::nodes_visited);
     if(node.axis_leaf == bsp_leaf)
     {
+        render_stats.add(RenderStats::primitives_tested, node.count);
         bool found = false;
         for(unsigned int i = 0; i < node.count; ++i)
         {
-            const AccObj* obj = tree_objects[node.id + i];
-            if(obj->geometry->intersect(ray, hit, obj->prim_idx))
+            const AccObj& obj = primitives[tree_objects[node.id + i]];
+            if(obj.geometry->intersect(ray, hit, obj.prim_idx))
             {
                 ray.tmax = hit.dist;
                 found = true;
@@ -268,19 +321,19 @@ bool BspTree::intersect_node(Ray& ray, HitInfo& hit, const BspNode& node) const
     }
     else
     {
-        BspNode *near_node;
-        BspNode *far_node;
+        const BspNode *near_node;
+        const BspNode *far_node;
         float axis_direction = *(&ray.direction.x + node.axis_leaf);
         float axis_origin = *(&ray.origin.x + node.axis_leaf);
         if(axis_direction >= 0.0f)
         {
-            near_node = node.left;
-            far_node = node.right;
+            near_node = &nodes[node.left];
+            far_node = &nodes[node.right];
         }
         else
         {
-            near_node = node.right;
-            far_node = node.left;
+            near_node = &nodes[node.right];
+            far_node = &nodes[node.left];
         }
 
         // In order to avoid instability
@@ -310,14 +363,83 @@ bool BspTree::intersect_node(Ray& ray, HitInfo& hit, const BspNode& node) const
     }
 }
 
-void BspTree::delete_node(BspNode *node)
+unsigned long long BspTree::compute_cache_key() const
 {
-    if(node)
+    // The build only depends on the primitive bounding boxes, the
+    // scene bounding box, and the build parameters.
+    unsigned long long key = fnv_hash(&cache_version, sizeof(cache_version));
+    key = fnv_hash(&max_objects, sizeof(max_objects), key);
+    key = fnv_hash(&max_level, sizeof(max_level), key);
+    key = fnv_hash(&bbox, sizeof(bbox), key);
+    unsigned int no_of_prims = primitives.size();
+    key = fnv_hash(&no_of_prims, sizeof(no_of_prims), key);
+    for(unsigned int i = 0; i < primitives.size(); ++i)
+        key = fnv_hash(&primitives[i].bbox, sizeof(Aabb), key);
+    return key;
+}
+
+bool BspTree::load_cache(const string& filename, unsigned long long key)
+{
+    MappedFile* file = new MappedFile(filename);
+    CacheHeader header;
+    if(!file->is_open() || file->get_size() < sizeof(header))
+    {
+        delete file;
+        return false;
+    }
+    memcpy(&header, file->begin(), sizeof(header));
+    size_t size = sizeof(header) + header.no_of_nodes*sizeof(BspNode) + header.no_of_tree_objects*sizeof(unsigned int);
+    if(memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version
+       || header.key != key || header.no_of_nodes == 0 || file->get_size() != size)
+    {
+        delete file;
+        return false;
+    }
+
+    // Use the nodes and leaf indices directly from the mapped file
+    const char* data = file->begin() + sizeof(header);
+    nodes = reinterpret_cast<const BspNode*>(data);
+    tree_objects = reinterpret_cast<const unsigned int*>(data + header.no_of_nodes*sizeof(BspNode));
+    bool valid = true;
+    for(unsigned int i = 0; i < header.no_of_nodes && valid; ++i)
+        if(nodes[i].axis_leaf == bsp_leaf)
+            valid = nodes[i].id + nodes[i].count <= header.no_of_tree_objects;
+        else
+            valid = nodes[i].left < header.no_of_nodes && nodes[i].right < header.no_of_nodes;
+    for(unsigned int i = 0; i < header.no_of_tree_objects && valid; ++i)
+        valid = tree_objects[i] < primitives.size();
+    if(!valid)
+    {
+        nodes = 0;
+        tree_objects = 0;
+        delete file;
+        return false;
+    }
+    cache = file;
+    return true;
+}
+
+void BspTree::save_cache(const string& filename, unsigned long long key) const
+{
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.no_of_nodes = node_storage.size();
+    header.key = key;
+    header.no_of_tree_objects = tree_object_storage.size();
+
+    string tmp_file = filename + ".tmp";
+    FILE* out = fopen(tmp_file.c_str(), "wb");
+    if(!out)
     {
-        if(node->left)
-            delete_node(node->left);
-        if(node->right)
-            delete_node(node->right);
-        delete node;
+        cerr << "Could not write BSP tree cache " << filename << endl;
+        return;
     }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(&node_storage[0], sizeof(BspNode), node_storage.size(), out);
+    if(!tree_object_storage.empty())
+        fwrite(&tree_object_storage[0], sizeof(unsigned int), tree_object_storage.size(), out);
+    if(!commit_file(out, tmp_file, filename))
+        cerr << "Could not write BSP tree cache " << filename << endl;
 }
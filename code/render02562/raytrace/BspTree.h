@@ -8,22 +8,26 @@
 #define BSPTREE_H
 
 #include <vector>
+#include <string>
 #include <optix_world.h>
 #include "AccObj.h"
 #include "Object3D.h"
 #include "Plane.h"
 #include "HitInfo.h"
 #include "Accelerator.h"
+#include "MappedFile.h"
 
 enum BspNodeType { bsp_x_axis, bsp_y_axis, bsp_z_axis, bsp_leaf };
 
+// Nodes are stored in one array and refer to their children by index,
+// so that a built tree can be written to and mapped from a file as is.
 struct BspNode 
 {
-  BspNode() : left(0), right(0) { }
+  BspNode() : axis_leaf(bsp_leaf), plane(0.0f), left(0), right(0), id(0), count(0), ref(0) { }
 
   BspNodeType axis_leaf; // 00 = axis 0, 01 = axis 1, 10 = axis 2, 11 = leaf
   float plane;
-  BspNode *left, *right;
+  unsigned int left, right;
   unsigned int id;
   unsigned int count;
   unsigned int ref;
@@ -33,7 +37,7 @@ class BspTree : public Accelerator
 {
 public:
   BspTree(unsigned int max_objects_in_leaf = 4, unsigned int max_levels_in_tree = 20) 
-    : root(0), max_objects(max_objects_in_leaf), max_level(max_levels_in_tree) 
+    : nodes(0), tree_objects(0), cache(0), max_objects(max_objects_in_leaf), max_level(max_levels_in_tree) 
   { }
 
   virtual ~BspTree();
@@ -41,14 +45,29 @@ public:
   virtual bool closest_hit(optix::Ray& r, HitInfo& hit) const;
   virtual bool any_hit(optix::Ray& r, HitInfo& hit) const;
 
+  // Built trees are stored in and loaded from this file (no caching if empty).
+  // A tree built from other geometry or build parameters replaces the file.
+  void set_cache_file(const std::string& filename) { cache_file = filename; }
+
 private:
   bool intersect_min_max(optix::Ray& ray) const;
-  void subdivide_node(BspNode& node, optix::Aabb& bbox, unsigned int level, std::vector<AccObj*>& objects);
+  void subdivide_node(unsigned int node_idx, optix::Aabb& bbox, unsigned int level, std::vector<unsigned int>& objects);
   bool intersect_node(optix::Ray& ray, HitInfo& hit, const BspNode& node) const;
-  void delete_node(BspNode *node);
+  unsigned long long compute_cache_key() const;
+  bool load_cache(const std::string& filename, unsigned long long key);
+  void save_cache(const std::string& filename, unsigned long long key) const;
+
+  // Tree built in this run
+  std::vector<BspNode> node_storage;
+  std::vector<unsigned int> tree_object_storage;
+
+  // Point to the arrays above or into a mapped cache file. Leaves
+  // refer to primitives by their index in the primitives array.
+  const BspNode* nodes;
+  const unsigned int* tree_objects;
+  MappedFile* cache;
+  std::string cache_file;
 
-  std::vector<AccObj*> tree_objects;
-  BspNode* root;
   optix::Aabb bbox;
   unsigned int max_objects;
   unsigned int max_level;
@@ -0,0 +1,293 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include <algorithm>
+#include <optix_world.h>
+#include "AccObj.h"
+#include "Object3D.h"
+#include "HitInfo.h"
+#include "RenderStats.h"
+#include "Bvh.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+    const unsigned int no_of_bins = 12;
+    const unsigned int max_level = 64;     // also the size of the traversal stack
+
+    float center(const Aabb& bbox, unsigned int axis)
+    {
+        return 0.5f*(*(&bbox.m_min.x + axis) + *(&bbox.m_max.x + axis));
+    }
+
+    struct Bin
+    {
+        Aabb bbox;
+        unsigned int count;
+    };
+
+    struct InBin
+    {
+        InBin(const vector<AccObj>& prims, unsigned int split_axis, float bin_min, float bin_scale, unsigned int bin)
+            : primitives(prims), axis(split_axis), min(bin_min), scale(bin_scale), split(bin)
+        { }
+
+        unsigned int get_bin(unsigned int prim) const
+        {
+            float c = center(primitives[prim].bbox, axis);
+            unsigned int b = static_cast<unsigned int>((c - min)*scale);
+            return b < no_of_bins ? b : no_of_bins - 1;
+        }
+
+        bool operator()(unsigned int prim) const { return get_bin(prim) <= split; }
+
+        const vector<AccObj>& primitives;
+        unsigned int axis;
+        float min, scale;
+        unsigned int split;
+    };
+
+    struct CenterLess
+    {
+        CenterLess(const vector<AccObj>& prims, unsigned int split_axis) : primitives(prims), axis(split_axis) { }
+
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return center(primitives[a].bbox, axis) < center(primitives[b].bbox, axis);
+        }
+
+        const vector<AccObj>& primitives;
+        unsigned int axis;
+    };
+}
+
+void Bvh::init(const vector<Object3D*>& geometry, const vector<const Plane*>& scene_planes)
+{
+    Accelerator::init(geometry, scene_planes);
+    tree_objects.resize(primitives.size());
+    for(unsigned int i = 0; i < tree_objects.size(); ++i)
+        tree_objects[i] = i;
+    nodes.clear();
+    if(primitives.empty())
+        return;
+    nodes.reserve(2*primitives.size()/max_objects + 1);
+    nodes.resize(1);
+    subdivide_node(0, 0, primitives.size(), 0);
+}
+
+void Bvh::subdivide_node(unsigned int node_idx, unsigned int first, unsigned int count, unsigned int level)
+{
+    Aabb bbox, centroid_bbox;
+    for(unsigned int i = first; i < first + count; ++i)
+    {
+        const Aabb& obj_bbox = primitives[tree_objects[i]].bbox;
+        bbox.include(obj_bbox);
+        centroid_bbox.include(obj_bbox.center());
+    }
+    nodes[node_idx].bbox = bbox;
+    nodes[node_idx].first = first;
+    nodes[node_idx].count = count;
+    if(count <= max_objects || level == max_level - 1)
+        return;
+
+    // Bin the primitive centroids along each axis and find the split with
+    // minimum cost using the surface area heuristic
+    float min_cost = count*bbox.area();
+    unsigned int best_axis = 3;
+    unsigned int best_split = 0;
+    for(unsigned int axis = 0; axis < 3; ++axis)
+    {
+        float min = *(&centroid_bbox.m_min.x + axis);
+        float extent = *(&centroid_bbox.m_max.x + axis) - min;
+        if(extent <= 0.0f)
+            continue;
+
+        InBin in_bin(primitives, axis, min, no_of_bins/extent, 0);
+        Bin bins[no_of_bins];
+        for(unsigned int b = 0; b < no_of_bins; ++b)
+            bins[b].count = 0;
+        for(unsigned int i = first; i < first + count; ++i)
+        {
+            Bin& bin = bins[in_bin.get_bin(tree_objects[i])];
+            bin.bbox.include(primitives[tree_objects[i]].bbox);
+            ++bin.count;
+        }
+
+        // Sweep from the right to get the cost of the right side of each split
+        float right_cost[no_of_bins];
+        Aabb right_bbox;
+        unsigned int right_count = 0;
+        for(unsigned int b = no_of_bins - 1; b > 0; --b)
+        {
+            right_bbox.include(bins[b].bbox);
+            right_count += bins[b].count;
+            right_cost[b - 1] = right_count > 0 ? right_count*right_bbox.area() : 0.0f;
+        }
+        Aabb left_bbox;
+        unsigned int left_count = 0;
+        for(unsigned int b = 0; b < no_of_bins - 1; ++b)
+        {
+            left_bbox.include(bins[b].bbox);
+            left_count += bins[b].count;
+            if(left_count == 0 || left_count == count)
+                continue;
+            float cost = left_count*left_bbox.area() + right_cost[b];
+            if(cost < min_cost)
+            {
+                min_cost = cost;
+                best_axis = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    unsigned int* begin = &tree_objects[first];
+    unsigned int* middle;
+    if(best_axis < 3)
+    {
+        float min = *(&centroid_bbox.m_min.x + best_axis);
+        float extent = *(&centroid_bbox.m_max.x + best_axis) - min;
+        middle = partition(begin, begin + count, InBin(primitives, best_axis, min, no_of_bins/extent, best_split));
+    }
+    else if(count > 4*max_objects)
+    {
+        // Splitting is not worth it by the heuristic, but the leaf would be
+        // too big. Split at the median along the largest centroid extent.
+        float3 extent = centroid_bbox.extent();
+        unsigned int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        middle = begin + count/2;
+        nth_element(begin, middle, begin + count, CenterLess(primitives, axis));
+    }
+    else
+        return;
+
+    unsigned int left_count = middle - begin;
+    unsigned int left = nodes.size();
+    nodes[node_idx].first = left;
+    nodes[node_idx].count = 0;
+    nodes.resize(nodes.size() + 2);
+    subdivide_node(left, first, left_count, level + 1);
+    subdivide_node(left + 1, first + left_count, count - left_count, level + 1);
+}
+
+bool Bvh::closest_hit(Ray& r, HitInfo& hit) const
+{
+    closest_plane(r, hit);
+    intersect_nodes(r, hit, false);
+    return hit.has_hit;
+}
+
+bool Bvh::any_hit(Ray& r, HitInfo& hit) const
+{
+    if(any_plane(r, hit))
+        return true;
+    return intersect_nodes(r, hit, true);
+}
+
+void Bvh::refit()
+{
+    for(unsigned int i = 0; i < primitives.size(); ++i)
+        primitives[i].bbox = primitives[i].geometry->get_primitive_bbox(primitives[i].prim_idx);
+
+    // Children are stored after their parents
+    for(unsigned int i = nodes.size(); i-- > 0;)
+    {
+        BvhNode& node = nodes[i];
+        node.bbox.invalidate();
+        if(node.count > 0)
+        {
+            for(unsigned int j = node.first; j < node.first + node.count; ++j)
+                node.bbox.include(primitives[tree_objects[j]].bbox);
+        }
+        else
+        {
+            node.bbox.include(nodes[node.first].bbox);
+            node.bbox.include(nodes[node.first + 1].bbox);
+        }
+    }
+}
+
+bool Bvh::intersect_bbox(const Aabb& bbox, const Ray& r, const float3& inv_dir, float& t) const
+{
+    float3 p1 = (bbox.m_min - r.origin)*inv_dir;
+    float3 p2 = (bbox.m_max - r.origin)*inv_dir;
+    float tmin = fmaxf(fminf(p1, p2));
+    float tmax = fminf(fmaxf(p1, p2));
+    t = tmin;
+    return tmin <= tmax && tmin <= r.tmax && tmax >= r.tmin;
+}
+
+bool Bvh::intersect_nodes(Ray& r, HitInfo& hit, bool any) const
+{
+    if(nodes.empty())
+        return false;
+
+    float3 inv_dir = make_float3(1.0f)/r.direction;
+    float t;
+    if(!intersect_bbox(nodes[0].bbox, r, inv_dir, t))
+        return false;
+
+    // Visit the nearest child first and keep the other one on a stack
+    unsigned int stack[max_level];
+    unsigned int stack_size = 0;
+    unsigned int node_idx = 0;
+    unsigned int nodes_visited = 0, primitives_tested = 0;
+    bool found = false;
+    for(;;)
+    {
+        const BvhNode& node = nodes[node_idx];
+        ++nodes_visited;
+        if(node.count > 0)
+        {
+            primitives_tested += node.count;
+            for(unsigned int i = node.first; i < node.first + node.count; ++i)
+            {
+                const AccObj& obj = primitives[tree_objects[i]];
+                if(obj.geometry->intersect(r, hit, obj.prim_idx))
+                {
+                    r.tmax = hit.dist;
+                    found = true;
+                    if(any)
+                        break;
+                }
+            }
+            if(found && any)
+                break;
+        }
+        else
+        {
+            float t_left, t_right;
+            bool left = intersect_bbox(nodes[node.first].bbox, r, inv_dir, t_left);
+            bool right = intersect_bbox(nodes[node.first + 1].bbox, r, inv_dir, t_right);
+            if(left && right)
+            {
+                bool left_first = t_left <= t_right;
+                stack[stack_size++] = left_first ? node.first + 1 : node.first;
+                node_idx = left_first ? node.first : node.first + 1;
+                continue;
+            }
+            if(left || right)
+            {
+                node_idx = left ? node.first : node.first + 1;
+                continue;
+            }
+        }
+
+        // Pop nodes that are still in front of the closest hit
+        bool next = false;
+        while(stack_size > 0 && !next)
+        {
+            node_idx = stack[--stack_size];
+            next = intersect_bbox(nodes[node_idx].bbox, r, inv_dir, t);
+        }
+        if(!next)
+            break;
+    }
+    render_stats.add(RenderStats::nodes_visited, nodes_visited);
+    render_stats.add(RenderStats::primitives_tested, primitives_tested);
+    return found;
+}
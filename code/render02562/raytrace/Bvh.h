@@ -0,0 +1,52 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <optix_world.h>
+#include "AccObj.h"
+#include "Object3D.h"
+#include "Plane.h"
+#include "HitInfo.h"
+#include "Accelerator.h"
+
+// The two children of an interior node are stored next to each other
+// and after their parent, so bounds can be refitted in one backwards pass.
+struct BvhNode
+{
+  BvhNode() : first(0), count(0) { }
+
+  optix::Aabb bbox;
+  unsigned int first;   // index of the left child or of the first primitive index in a leaf
+  unsigned int count;   // number of primitives in a leaf (0 for interior nodes)
+};
+
+// Bounding volume hierarchy built using the surface area heuristic.
+// Unlike the BSP tree, it can be refitted to primitives that have moved.
+class Bvh : public Accelerator
+{
+public:
+  Bvh(unsigned int max_objects_in_leaf = 4) : max_objects(max_objects_in_leaf) { }
+
+  virtual void init(const std::vector<Object3D*>& geometry, const std::vector<const Plane*>& planes);
+  virtual bool closest_hit(optix::Ray& r, HitInfo& hit) const;
+  virtual bool any_hit(optix::Ray& r, HitInfo& hit) const;
+
+  // Update all bounding boxes after the geometry has moved or deformed.
+  // The tree topology is kept, so large changes reduce traversal speed.
+  void refit();
+
+private:
+  void subdivide_node(unsigned int node_idx, unsigned int first, unsigned int count, unsigned int level);
+  bool intersect_bbox(const optix::Aabb& bbox, const optix::Ray& r, const optix::float3& inv_dir, float& t) const;
+  bool intersect_nodes(optix::Ray& r, HitInfo& hit, bool any) const;
+
+  std::vector<BvhNode> nodes;
+  std::vector<unsigned int> tree_objects;   // primitive indices referred to by leaves
+  unsigned int max_objects;
+};
+
+#endif // BVH_H
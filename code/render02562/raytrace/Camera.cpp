@@ -66,6 +66,16 @@ Ray Camera::get_ray(const float2& coords) const
     return Ray(eye, get_ray_dir(coords), 0, 0);
 }
 
+void Camera::get_ray_differentials(const float2& coords, const float2& pixel_size, float3& dddx, float3& dddy) const
+{
+    // Derivatives of the normalized direction d/|d| with respect to the image coords
+    float3 d = ip_xaxis*coords.x + ip_yaxis*coords.y + ip_normal*cam_const;
+    float d_sqr = dot(d, d);
+    float d_cube = d_sqr*sqrt(d_sqr);
+    dddx = (d_sqr*ip_xaxis - dot(d, ip_xaxis)*d)*(pixel_size.x/d_cube);
+    dddy = (d_sqr*ip_yaxis - dot(d, ip_yaxis)*d)*(pixel_size.y/d_cube);
+}
+
 // OpenGL
 
 void Camera::glSetPerspective(unsigned int width, unsigned int height) const
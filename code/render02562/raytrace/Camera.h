@@ -38,6 +38,10 @@ public:
   /// Return the ray corresponding to a set of image coords
   optix::Ray get_ray(const optix::float2& coords) const;
 
+  /// Differentials of the ray direction when the image coords change by the pixel size
+  void get_ray_differentials(const optix::float2& coords, const optix::float2& pixel_size, 
+                             optix::float3& dddx, optix::float3& dddy) const;
+
   float get_fov() const { return fov; }
   float get_cam_const() const { return cam_const; }
   void set_cam_const(float camera_constant) { set(eye, lookat, up, camera_constant); }
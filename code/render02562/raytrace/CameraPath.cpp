@@ -0,0 +1,99 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <optix_world.h>
+#include "Camera.h"
+#include "CameraPath.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+    float3 catmull_rom(const float3& p0, const float3& p1, const float3& p2, const float3& p3, float t)
+    {
+        float t2 = t*t;
+        float t3 = t2*t;
+        return 0.5f*(2.0f*p1 + (p2 - p0)*t + (2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3)*t2 + (3.0f*p1 - p0 - 3.0f*p2 + p3)*t3);
+    }
+}
+
+bool CameraPath::load(const string& filename)
+{
+    ifstream file(filename.c_str());
+    if(!file)
+    {
+        cerr << "Could not open " << filename << endl;
+        return false;
+    }
+
+    keys.clear();
+    string line;
+    for(unsigned int line_no = 1; getline(file, line); ++line_no)
+    {
+        istringstream in(line);
+        Keyframe key;
+        if(!(in >> key.time))
+        {
+            // Skip comments and blank lines
+            string word;
+            istringstream rest(line);
+            if(rest >> word && word[0] != '#')
+                cerr << filename << "(" << line_no << "): Expected a keyframe time" << endl;
+            continue;
+        }
+        if(!(in >> key.eye.x >> key.eye.y >> key.eye.z 
+                >> key.lookat.x >> key.lookat.y >> key.lookat.z 
+                >> key.up.x >> key.up.y >> key.up.z >> key.cam_const))
+        {
+            cerr << filename << "(" << line_no << "): Expected eye, look-at, up, and camera constant" << endl;
+            continue;
+        }
+        if(!keys.empty() && key.time <= keys.back().time)
+        {
+            cerr << filename << "(" << line_no << "): Keyframe times must be increasing" << endl;
+            continue;
+        }
+        keys.push_back(key);
+    }
+    return !keys.empty();
+}
+
+void CameraPath::set_camera(float time, Camera& cam) const
+{
+    if(keys.empty())
+        return;
+
+    // Find the segment containing the time
+    unsigned int i = 0;
+    while(i + 2 < keys.size() && keys[i + 1].time <= time)
+        ++i;
+    if(keys.size() == 1 || time <= keys.front().time)
+    {
+        cam.set(keys.front().eye, keys.front().lookat, keys.front().up, keys.front().cam_const);
+        return;
+    }
+    if(time >= keys.back().time)
+    {
+        cam.set(keys.back().eye, keys.back().lookat, keys.back().up, keys.back().cam_const);
+        return;
+    }
+
+    // End points are repeated to get tangents at the ends of the path
+    const Keyframe& k0 = keys[i > 0 ? i - 1 : 0];
+    const Keyframe& k1 = keys[i];
+    const Keyframe& k2 = keys[i + 1];
+    const Keyframe& k3 = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+    float t = (time - k1.time)/(k2.time - k1.time);
+    float3 eye = catmull_rom(k0.eye, k1.eye, k2.eye, k3.eye, t);
+    float3 lookat = catmull_rom(k0.lookat, k1.lookat, k2.lookat, k3.lookat, t);
+    float3 up = normalize(lerp(k1.up, k2.up, t));
+    float cam_const = k1.cam_const + (k2.cam_const - k1.cam_const)*t;
+    cam.set(eye, lookat, up, cam_const);
+}
@@ -0,0 +1,43 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <vector>
+#include <string>
+#include <optix_world.h>
+#include "Camera.h"
+
+// Camera keyframes read from a text file with one keyframe per line:
+//
+//   time  eye_x eye_y eye_z  lookat_x lookat_y lookat_z  up_x up_y up_z  camera_constant
+//
+// Lines starting with '#' are comments. Eye and look-at points are
+// interpolated with Catmull-Rom splines, the rest linearly.
+class CameraPath
+{
+public:
+  bool load(const std::string& filename);
+
+  unsigned int get_no_of_keyframes() const { return keys.size(); }
+  float get_start_time() const { return keys.empty() ? 0.0f : keys.front().time; }
+  float get_end_time() const { return keys.empty() ? 0.0f : keys.back().time; }
+  float get_keyframe_time(unsigned int i) const { return keys[i].time; }
+
+  // Set the camera to its position on the path at the given time
+  void set_camera(float time, Camera& cam) const;
+
+private:
+  struct Keyframe
+  {
+    float time;
+    optix::float3 eye, lookat, up;
+    float cam_const;
+  };
+
+  std::vector<Keyframe> keys;
+};
+
+#endif // CAMERAPATH_H
@@ -0,0 +1,244 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <optix_world.h>
+#include "HitInfo.h"
+#include "TriMesh.h"
+#include "CompactTriMesh.h"
+#include "ray_differentials.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+    const unsigned int no_index = ~0u;
+
+    // Corner of a triangle identified by its position, normal, and texture
+    // coordinate indices. Corners with the same key share a vertex.
+    struct Corner
+    {
+        unsigned int geo, normal, texcoord;
+        unsigned int idx;
+
+        bool operator<(const Corner& c) const 
+        {
+            if(geo != c.geo) return geo < c.geo;
+            if(normal != c.normal) return normal < c.normal;
+            return texcoord < c.texcoord;
+        }
+        bool same_vertex(const Corner& c) const 
+        {
+            return geo == c.geo && normal == c.normal && texcoord == c.texcoord;
+        }
+    };
+
+    unsigned int quantize16(float x)
+    {
+        return static_cast<unsigned int>(clamp(x, 0.0f, 1.0f)*65535.0f + 0.5f);
+    }
+
+    float dequantize16(unsigned int q)
+    {
+        return q/65535.0f;
+    }
+
+    float sign_not_zero(float x) { return x >= 0.0f ? 1.0f : -1.0f; }
+
+    // Octahedral normal vectors (Meyer et al. 2010)
+    unsigned int encode_octahedral(const float3& n)
+    {
+        float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+        if(l1 == 0.0f)
+            return (quantize16(0.5f) << 16) | quantize16(0.5f);
+        float2 e = make_float2(n.x, n.y)/l1;
+        if(n.z < 0.0f)
+            e = make_float2((1.0f - fabsf(e.y))*sign_not_zero(e.x), (1.0f - fabsf(e.x))*sign_not_zero(e.y));
+        return (quantize16(e.y*0.5f + 0.5f) << 16) | quantize16(e.x*0.5f + 0.5f);
+    }
+
+    float3 decode_octahedral(unsigned int q)
+    {
+        float2 e = make_float2(dequantize16(q & 0xffff), dequantize16(q >> 16))*2.0f - 1.0f;
+        float3 n = make_float3(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+        float t = fmaxf(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return normalize(n);
+    }
+}
+
+CompactTriMesh::CompactTriMesh(const TriMesh& mesh)
+    : materials(mesh.materials), texcoord_min(make_float2(0.0f)), texcoord_scale(make_float2(1.0f))
+{
+    const unsigned int no_of_faces = mesh.geometry.no_faces();
+    const bool has_normals = mesh.has_normals();
+    const bool has_texcoords = mesh.texcoords.no_faces() > 0;
+
+    // Merge the index triples of all corners into one vertex index
+    vector<Corner> corners(no_of_faces*3);
+    for(unsigned int i = 0; i < no_of_faces; ++i)
+    {
+        const unsigned int* g = &mesh.geometry.face(i).x;
+        uint3 nf = has_normals && i < mesh.normals.no_faces() ? mesh.normals.face(i) : make_uint3(0);
+        uint3 tf = has_texcoords && i < mesh.texcoords.no_faces() ? mesh.texcoords.face(i) : make_uint3(0);
+        for(unsigned int j = 0; j < 3; ++j)
+        {
+            Corner& c = corners[i*3 + j];
+            c.geo = g[j];
+            c.normal = has_normals ? (&nf.x)[j] : no_index;
+            c.texcoord = has_texcoords ? (&tf.x)[j] : no_index;
+            c.idx = i*3 + j;
+        }
+    }
+    sort(corners.begin(), corners.end());
+
+    vector<unsigned int> vertex_of_corner(corners.size());
+    vector<unsigned int> first_corner;
+    for(unsigned int i = 0; i < corners.size(); ++i)
+    {
+        if(i == 0 || !corners[i].same_vertex(corners[i - 1]))
+            first_corner.push_back(i);
+        vertex_of_corner[corners[i].idx] = first_corner.size() - 1;
+    }
+
+    // Vertex attributes
+    if(has_texcoords)
+    {
+        float2 tmin = make_float2(1.0e37f);
+        float2 tmax = make_float2(-1.0e37f);
+        for(unsigned int i = 0; i < mesh.texcoords.no_vertices(); ++i)
+        {
+            float2 t = make_float2(mesh.texcoords.vertex(i));
+            tmin = fminf(tmin, t);
+            tmax = fmaxf(tmax, t);
+        }
+        if(tmin.x <= tmax.x)
+        {
+            texcoord_min = tmin;
+            texcoord_scale = fmaxf(tmax - tmin, make_float2(1.0e-6f));
+        }
+    }
+    positions.resize(first_corner.size());
+    if(has_normals)
+        normals.resize(first_corner.size());
+    if(has_texcoords)
+        texcoords.resize(first_corner.size());
+    for(unsigned int i = 0; i < first_corner.size(); ++i)
+    {
+        const Corner& c = corners[first_corner[i]];
+        positions[i] = mesh.geometry.vertex(c.geo);
+        if(has_normals)
+            normals[i] = encode_octahedral(mesh.normals.vertex(c.normal));
+        if(has_texcoords)
+        {
+            float2 t = (make_float2(mesh.texcoords.vertex(c.texcoord)) - texcoord_min)/texcoord_scale;
+            texcoords[i] = (quantize16(t.y) << 16) | quantize16(t.x);
+        }
+    }
+
+    // Faces and material indices
+    faces.resize(no_of_faces);
+    for(unsigned int i = 0; i < no_of_faces; ++i)
+        faces[i] = make_uint3(vertex_of_corner[i*3], vertex_of_corner[i*3 + 1], vertex_of_corner[i*3 + 2]);
+    if(materials.size() <= 256)
+        mat_idx8.assign(mesh.mat_idx.begin(), mesh.mat_idx.end());
+    else
+    {
+        if(materials.size() > 65536)
+            cerr << "Compact meshes support at most 65536 materials" << endl;
+        mat_idx16.assign(mesh.mat_idx.begin(), mesh.mat_idx.end());
+    }
+}
+
+bool CompactTriMesh::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
+{
+    const uint3& face = faces[prim_idx];
+    float3 normal;
+    float dist, v, w;
+    if(!optix::intersect_triangle(r, positions[face.x], positions[face.y], positions[face.z], normal, dist, v, w))
+        return false;
+
+    hit.has_hit = true;
+    hit.dist = dist;
+    hit.object = this;
+    hit.prim_idx = prim_idx;
+    hit.barycentrics = make_float2(v, w);
+    return true;
+}
+
+void CompactTriMesh::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    float v = hit.barycentrics.x;
+    float w = hit.barycentrics.y;
+    const uint3& face = faces[hit.prim_idx];
+    const float3& v0 = positions[face.x];
+    hit.geometric_normal = normalize(cross(positions[face.y] - v0, positions[face.z] - v0));
+
+    if(!normals.empty())
+        hit.shading_normal = normalize((1-v-w)*get_normal(face.x) + v*get_normal(face.y) + w*get_normal(face.z));
+    else
+        hit.shading_normal = hit.geometric_normal;
+
+    if(!texcoords.empty())
+    {
+        float3 t0 = get_texcoord(face.x);
+        float3 t1 = get_texcoord(face.y);
+        float3 t2 = get_texcoord(face.z);
+        hit.texcoord = (1-v-w)*t0 + v*t1 + w*t2;
+        compute_texcoord_differentials(r, hit, v0, positions[face.y], positions[face.z],
+                                       make_float2(t0), make_float2(t1), make_float2(t2));
+    }
+
+    hit.material = &materials[get_material_index(hit.prim_idx)];
+    hit.position = r.origin + r.direction*hit.dist;
+}
+
+void CompactTriMesh::transform(const Matrix4x4& m)
+{
+    for(unsigned int i = 0; i < positions.size(); ++i)
+        positions[i] = make_float3(m*make_float4(positions[i], 1.0f));
+    for(unsigned int i = 0; i < normals.size(); ++i)
+        normals[i] = encode_octahedral(make_float3(m*make_float4(get_normal(i), 0.0f)));
+}
+
+Aabb CompactTriMesh::compute_bbox() const
+{
+    Aabb bbox;
+    for(unsigned int i = 0; i < positions.size(); ++i)
+        bbox.include(positions[i]);
+    return bbox;
+}
+
+Aabb CompactTriMesh::get_primitive_bbox(unsigned int prim_idx) const
+{
+    Aabb bbox;
+    const uint3& face = faces[prim_idx];
+    bbox.include(positions[face.x]);
+    bbox.include(positions[face.y]);
+    bbox.include(positions[face.z]);
+    return bbox;
+}
+
+size_t CompactTriMesh::get_memory_footprint() const
+{
+    return positions.size()*sizeof(float3) + normals.size()*sizeof(unsigned int) 
+        + texcoords.size()*sizeof(unsigned int) + faces.size()*sizeof(uint3)
+        + mat_idx8.size()*sizeof(unsigned char) + mat_idx16.size()*sizeof(unsigned short);
+}
+
+float3 CompactTriMesh::get_normal(unsigned int vertex) const
+{
+    return decode_octahedral(normals[vertex]);
+}
+
+float3 CompactTriMesh::get_texcoord(unsigned int vertex) const
+{
+    unsigned int q = texcoords[vertex];
+    float2 t = texcoord_min + make_float2(dequantize16(q & 0xffff), dequantize16(q >> 16))*texcoord_scale;
+    return make_float3(t.x, t.y, 1.0f);
+}
@@ -0,0 +1,65 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef COMPACTTRIMESH_H
+#define COMPACTTRIMESH_H
+
+#include <vector>
+#include <optix_world.h>
+#include "ObjMaterial.h"
+#include "HitInfo.h"
+#include "Object3D.h"
+#include "TriMesh.h"
+
+/** \brief Memory-efficient triangle mesh for ray tracing.
+
+    Built from a TriMesh. Position, normal, and texture coordinate indices
+    are merged into a single index buffer. Normals are octahedral-encoded
+    in 2x16 bits, texture coordinates are quantized to 2x16 bits over
+    their range, and material indices use 8 bits (16 bits if there are more
+    than 256 materials). */
+class CompactTriMesh : public Object3D
+{
+public:
+  CompactTriMesh(const TriMesh& mesh);
+
+  virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int prim_idx) const;
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const;
+  virtual void transform(const optix::Matrix4x4& m);
+  virtual optix::Aabb compute_bbox() const;
+  virtual unsigned int get_no_of_primitives() const { return faces.size(); }
+  virtual optix::Aabb get_primitive_bbox(unsigned int prim_idx) const;
+
+  /// Bytes used for vertex, face, and material index data
+  size_t get_memory_footprint() const;
+
+  unsigned int get_material_index(unsigned int prim_idx) const 
+  {
+    return mat_idx8.empty() ? mat_idx16[prim_idx] : mat_idx8[prim_idx];
+  }
+
+  const std::vector<ObjMaterial>& get_materials() const { return materials; }
+
+  /// Per-vertex access that decodes one vertex at a time (for drawing the mesh)
+  unsigned int get_no_of_vertices() const { return positions.size(); }
+  const optix::uint3& get_face(unsigned int prim_idx) const { return faces[prim_idx]; }
+  const optix::float3& get_position(unsigned int vertex) const { return positions[vertex]; }
+  bool has_normals() const { return !normals.empty(); }
+  optix::float3 get_normal(unsigned int vertex) const;
+
+private:
+  optix::float3 get_texcoord(unsigned int vertex) const;
+
+  std::vector<optix::float3> positions;
+  std::vector<unsigned int> normals;      // Octahedral encoding, 2x16 bits
+  std::vector<unsigned int> texcoords;    // Quantized to texcoord_min + [0,1]*texcoord_scale, 2x16 bits
+  std::vector<optix::uint3> faces;
+  std::vector<unsigned char> mat_idx8;
+  std::vector<unsigned short> mat_idx16;
+  std::vector<ObjMaterial> materials;
+  optix::float2 texcoord_min;
+  optix::float2 texcoord_scale;
+};
+
+#endif // COMPACTTRIMESH_H
@@ -0,0 +1,137 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include <cmath>
+#include <optix_world.h>
+#include "Aovs.h"
+#include "Denoiser.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+    // B3 spline kernel of the a-trous transform
+    const float kernel[5] = { 1.0f/16.0f, 1.0f/4.0f, 3.0f/8.0f, 1.0f/4.0f, 1.0f/16.0f };
+
+    // Albedo that is safe to divide by (black albedo leaves the color as it is)
+    inline float3 demodulation_albedo(const float3& albedo)
+    {
+        return make_float3(albedo.x > 1.0e-3f ? albedo.x : 1.0f,
+                           albedo.y > 1.0e-3f ? albedo.y : 1.0f,
+                           albedo.z > 1.0e-3f ? albedo.z : 1.0f);
+    }
+}
+
+void Denoiser::apply(float3* image, const Aovs* aovs, unsigned int w, unsigned int h) const
+{
+    if(!image || !aovs || iterations == 0)
+        return;
+    int size = w*h;
+
+    // Filter the illumination only
+    vector<float3> buffer(size), temp(size);
+    #pragma omp parallel for
+    for(int i = 0; i < size; ++i)
+        buffer[i] = image[i]/demodulation_albedo(aovs[i].albedo);
+
+    // Ping-pong between two buffers with growing holes in the kernel.
+    // The variance is filtered along with the color so that the edge
+    // stopping function gets stricter as the noise goes down.
+    vector<float> variance(size), var_temp(size);
+    estimate_variance(&buffer[0], &variance[0], aovs, w, h);
+    for(unsigned int i = 0; i < iterations; ++i)
+    {
+        filter_pass(&buffer[0], &variance[0], &temp[0], &var_temp[0], aovs, w, h, 1 << i);
+        buffer.swap(temp);
+        variance.swap(var_temp);
+    }
+
+    #pragma omp parallel for
+    for(int i = 0; i < size; ++i)
+        image[i] = buffer[i]*demodulation_albedo(aovs[i].albedo);
+}
+
+float Denoiser::geometry_weight(const Aovs& a_p, const Aovs& a_q, float depth_scale) const
+{
+    float3 da = a_q.albedo - a_p.albedo;
+    float cos_n = fmaxf(dot(a_p.normal, a_q.normal), 0.0f);
+    return powf(cos_n, normal_power)*expf(-dot(da, da)/(sigma_albedo*sigma_albedo) 
+                                          - fabsf(a_q.depth - a_p.depth)*depth_scale);
+}
+
+void Denoiser::estimate_variance(const float3* in, float* variance, const Aovs* aovs, 
+                                 unsigned int w, unsigned int h) const
+{
+    // Luminance variance in a 7x7 neighborhood of similar surface points
+    #pragma omp parallel for
+    for(int y = 0; y < static_cast<int>(h); ++y)
+    {
+        for(int x = 0; x < static_cast<int>(w); ++x)
+        {
+            int p = y*w + x;
+            const Aovs& a_p = aovs[p];
+            float depth_scale = 1.0f/(sigma_depth*fmaxf(a_p.depth, 1.0e-4f));
+            float l = luminance(in[p]);
+            float sum = l, sum_sq = l*l, weight_sum = 1.0f;
+            for(int qy = max(y - 3, 0); qy <= min(y + 3, static_cast<int>(h) - 1); ++qy)
+                for(int qx = max(x - 3, 0); qx <= min(x + 3, static_cast<int>(w) - 1); ++qx)
+                {
+                    int q = qy*w + qx;
+                    if(q == p)
+                        continue;
+                    float weight = geometry_weight(a_p, aovs[q], depth_scale);
+                    l = luminance(in[q]);
+                    sum += l*weight;
+                    sum_sq += l*l*weight;
+                    weight_sum += weight;
+                }
+            float mean = sum/weight_sum;
+            variance[p] = fmaxf(sum_sq/weight_sum - mean*mean, 0.0f);
+        }
+    }
+}
+
+void Denoiser::filter_pass(const float3* in, const float* var_in, float3* out, float* var_out,
+                           const Aovs* aovs, unsigned int w, unsigned int h, int step) const
+{
+    #pragma omp parallel for
+    for(int y = 0; y < static_cast<int>(h); ++y)
+    {
+        for(int x = 0; x < static_cast<int>(w); ++x)
+        {
+            int p = y*w + x;
+            const Aovs& a_p = aovs[p];
+            float l_p = luminance(in[p]);
+            float depth_scale = 1.0f/(sigma_depth*step*fmaxf(a_p.depth, 1.0e-4f));
+            float luminance_scale = 1.0f/(sigma_luminance*sqrtf(var_in[p]) + 1.0e-4f);
+            float3 sum = make_float3(0.0f);
+            float var_sum = 0.0f;
+            float weight_sum = 0.0f;
+            for(int j = -2; j <= 2; ++j)
+            {
+                int qy = y + j*step;
+                if(qy < 0 || qy >= static_cast<int>(h))
+                    continue;
+                for(int i = -2; i <= 2; ++i)
+                {
+                    int qx = x + i*step;
+                    if(qx < 0 || qx >= static_cast<int>(w))
+                        continue;
+                    int q = qy*w + qx;
+                    float weight = kernel[i + 2]*kernel[j + 2];
+                    if(q != p)
+                        weight *= geometry_weight(a_p, aovs[q], depth_scale)
+                                  *expf(-fabsf(luminance(in[q]) - l_p)*luminance_scale);
+                    sum += in[q]*weight;
+                    var_sum += var_in[q]*weight*weight;
+                    weight_sum += weight;
+                }
+            }
+            out[p] = sum/weight_sum;
+            var_out[p] = var_sum/(weight_sum*weight_sum);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+#include <optix_world.h>
+#include "Aovs.h"
+
+/// Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) guided by 
+/// the first-hit albedo, normal, and depth of each pixel. The color is 
+/// divided by the albedo before filtering so that texture detail is kept,
+/// and luminance edges are measured relative to an estimate of the noise
+/// (as in spatiotemporal variance-guided filtering, Schied et al. 2017).
+class Denoiser
+{
+public:
+  Denoiser(unsigned int filter_iterations = 5, float luminance_sigma = 4.0f, 
+           float normal_exponent = 64.0f, float depth_sigma = 0.05f, float albedo_sigma = 0.1f)
+    : iterations(filter_iterations), sigma_luminance(luminance_sigma), 
+      normal_power(normal_exponent), sigma_depth(depth_sigma), sigma_albedo(albedo_sigma)
+  { }
+
+  /// Filter the w x h image in place using the auxiliary outputs of its pixels
+  void apply(optix::float3* image, const Aovs* aovs, unsigned int w, unsigned int h) const;
+
+  void set_iterations(unsigned int filter_iterations) { iterations = filter_iterations; }
+  unsigned int get_iterations() const { return iterations; }
+
+private:
+  float geometry_weight(const Aovs& a_p, const Aovs& a_q, float depth_scale) const;
+  void estimate_variance(const optix::float3* in, float* variance, const Aovs* aovs, 
+                         unsigned int w, unsigned int h) const;
+  void filter_pass(const optix::float3* in, const float* var_in, optix::float3* out, float* var_out,
+                   const Aovs* aovs, unsigned int w, unsigned int h, int step) const;
+
+  unsigned int iterations;  // Passes with hole sizes 1, 2, 4, ... (footprint 4*2^iterations + 1)
+  float sigma_luminance;    // Tolerated luminance difference in standard deviations of the noise
+  float normal_power;       // Exponent on the cosine between normals
+  float sigma_depth;        // Tolerated relative depth difference per pixel step
+  float sigma_albedo;       // Tolerated difference in albedo
+};
+
+#endif // DENOISER_H
@@ -0,0 +1,124 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include <optix_world.h>
+#include "mt_random.h"
+#include "HitInfo.h"
+#include "EnvironmentLight.h"
+
+using namespace std;
+using namespace optix;
+
+EnvironmentLight::EnvironmentLight(RayTracer* ray_tracer, const SphereTexture* environment_map, unsigned int no_of_samples)
+  : Light(ray_tracer, no_of_samples), tex(environment_map), width(0), height(0)
+{
+  build();
+}
+
+void EnvironmentLight::build()
+{
+  width = height = 0;
+  rows.clear();
+  texels.clear();
+  if(!tex->has_texture())
+    return;
+
+  // Rows are numbered from the top of the image as in the texture
+  width = tex->get_width();
+  height = tex->get_height();
+  texels.resize(height);
+  vector<float> row_weights(height, 0.0f);
+  vector<float> weights(width);
+  float2 no_footprint = make_float2(0.0f);
+  for(int i = 0; i < height; ++i)
+  {
+    for(int j = 0; j < width; ++j)
+    {
+      float u = (j + 0.5f)/width;
+      float v = 1.0f - (i + 0.5f)/height;
+      float3 d;
+      float solid_angle = tex->unproject_direction(u, v, d);
+      // (u, v) is on the map already, so the projection is bypassed
+      float3 radiance = make_float3(tex->Texture::sample_trilinear(make_float3(u, v, 0.0f), no_footprint, no_footprint));
+      weights[j] = solid_angle > 0.0f ? luminance(radiance)*solid_angle : 0.0f;
+      row_weights[i] += weights[j];
+    }
+    texels[i].build(weights);
+  }
+  rows.build(row_weights);
+}
+
+bool EnvironmentLight::sample(const float3& pos, float3& dir, float3& L) const
+{
+  // The radiance divided by the pdf estimates the light arriving from the whole environment
+  float pdf;
+  if(!sample_solid_angle(pos, dir, L, pdf))
+    return false;
+  L /= pdf;
+  return true;
+}
+
+bool EnvironmentLight::sample_solid_angle(const float3& pos, float3& dir, float3& L, float& pdf) const
+{
+  L = make_float3(0.0f);
+  pdf = 0.0f;
+  if(rows.empty())
+    return false;
+
+  // Pick a texel and a uniformly distributed position in it
+  unsigned int i = rows.sample(mt_random_half_open());
+  unsigned int j = texels[i].sample(mt_random_half_open());
+  float u = (j + static_cast<float>(mt_random()))/width;
+  float v = 1.0f - (i + static_cast<float>(mt_random()))/height;
+  float solid_angle = tex->unproject_direction(u, v, dir);
+  if(solid_angle <= 0.0f)
+    return false;
+
+  // Convert the density of the texel to a solid angle density
+  pdf = rows.prob(i)*texels[i].prob(j)*width*height/solid_angle;
+  if(pdf <= 0.0f || !is_visible(pos, dir))
+    return false;
+  L = get_radiance(dir);
+  return true;
+}
+
+bool EnvironmentLight::eval_solid_angle(const float3& pos, const float3& dir, float3& L, float& pdf) const
+{
+  L = make_float3(0.0f);
+  pdf = get_pdf(dir);
+  if(pdf <= 0.0f || !is_visible(pos, dir))
+    return false;
+  L = get_radiance(dir);
+  return true;
+}
+
+float3 EnvironmentLight::get_radiance(const float3& dir) const
+{
+  float2 no_footprint = make_float2(0.0f);
+  return make_float3(tex->sample_trilinear(dir, no_footprint, no_footprint));
+}
+
+float EnvironmentLight::get_pdf(const float3& dir) const
+{
+  if(rows.empty())
+    return 0.0f;
+
+  float u, v;
+  tex->project_direction(dir, u, v);
+  float3 d;
+  float solid_angle = tex->unproject_direction(u, v, d);
+  if(solid_angle <= 0.0f)
+    return 0.0f;
+  int i = min(static_cast<int>((1.0f - v)*height), height - 1);
+  int j = min(static_cast<int>(u*width), width - 1);
+  return rows.prob(i)*texels[i].prob(j)*width*height/solid_angle;
+}
+
+bool EnvironmentLight::is_visible(const float3& pos, const float3& dir) const
+{
+  Ray shadow_ray(pos, dir, 0, 1.0e-4f, RT_DEFAULT_MAX);
+  HitInfo hit;
+  return !shadows || !tracer->trace_to_any(shadow_ray, hit);
+}
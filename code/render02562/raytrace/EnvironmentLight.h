@@ -0,0 +1,50 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef ENVIRONMENTLIGHT_H
+#define ENVIRONMENTLIGHT_H
+
+#include <vector>
+#include <optix_world.h>
+#include "RayTracer.h"
+#include "SphereTexture.h"
+#include "AliasTable.h"
+#include "HitInfo.h"
+#include "Light.h"
+
+/** Light arriving from an environment map (usually the high dynamic range
+    background) that surrounds the scene. Directions are sampled in
+    proportion to the radiance of the texels times their solid angle, using
+    a table for picking a row of the map and a table per row for picking
+    a texel in the row. */
+class EnvironmentLight : public Light
+{
+public:
+  EnvironmentLight(RayTracer* ray_tracer, const SphereTexture* environment_map, unsigned int no_of_samples = 1);
+
+  // Build the sampling tables from the environment map (call again after loading it)
+  void build();
+
+  virtual bool sample(const optix::float3& pos, optix::float3& dir, optix::float3& L) const;
+  virtual bool sample_solid_angle(const optix::float3& pos, optix::float3& dir, optix::float3& L, float& pdf) const;
+  virtual bool eval_solid_angle(const optix::float3& pos, const optix::float3& dir, optix::float3& L, float& pdf) const;
+  virtual bool has_area() const { return true; }
+
+  // Radiance arriving from the direction dir (no visibility test)
+  optix::float3 get_radiance(const optix::float3& dir) const;
+
+  // Solid angle pdf of sampling the direction dir
+  float get_pdf(const optix::float3& dir) const;
+
+protected:
+  bool is_visible(const optix::float3& pos, const optix::float3& dir) const;
+
+  const SphereTexture* tex;
+  int width;
+  int height;
+  AliasTable rows;
+  std::vector<AliasTable> texels;
+};
+
+#endif // ENVIRONMENTLIGHT_H
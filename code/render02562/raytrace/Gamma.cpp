@@ -7,16 +7,56 @@
 
 using namespace std;
 
+Gamma::Gamma(double gamma, float exposure_scale)
+  : exponent(1.0/gamma)
+{
+  set_exposure(exposure_scale);
+}
+
+void Gamma::set_exposure(float exposure_scale)
+{
+  exposure = exposure_scale;
+  for(unsigned int k = 0; k < 255; ++k)
+    thresholds[k] = static_cast<float>(gamma_uncorrect((k + 0.5)/255.0)/exposure);
+  bucket_scale = no_of_buckets/thresholds[254];
+  unsigned int idx = 0;
+  for(unsigned int i = 0; i < no_of_buckets; ++i)
+  {
+    while(idx < 254 && thresholds[idx] <= i/bucket_scale)
+      ++idx;
+    buckets[i] = static_cast<unsigned char>(idx);
+  }
+}
+
 void Gamma::apply(float* data, unsigned int w, unsigned int h, unsigned int channels) const
 {
-  for(unsigned int i = 0; i < w*h*channels; ++i)
-    data[i] = static_cast<float>(gamma_correct(data[i]));
+  float e = static_cast<float>(exponent);
+  int size = w*h*channels;
+  #pragma omp parallel for
+  for(int i = 0; i < size; ++i)
+    data[i] = data[i] > 0.0f ? powf(data[i]*exposure, e) : 0.0f;
 }
 
 void Gamma::unapply(float* data, unsigned int w, unsigned int h, unsigned int channels) const
 {
-  for(unsigned int i = 0; i < w*h*channels; ++i)
-    data[i] = static_cast<float>(gamma_uncorrect(data[i]));
+  float e = static_cast<float>(1.0/exponent);
+  int size = w*h*channels;
+  #pragma omp parallel for
+  for(int i = 0; i < size; ++i)
+    data[i] = data[i] > 0.0f ? powf(data[i], e)/exposure : 0.0f;
+}
+
+void Gamma::apply_to_bytes(const float* data, unsigned char* out, unsigned int w, unsigned int h, unsigned int channels) const
+{
+  unsigned int row_size = w*channels;
+  #pragma omp parallel for
+  for(int j = 0; j < static_cast<int>(h); ++j)
+  {
+    const float* in_row = data + (h - j - 1)*row_size;
+    unsigned char* out_row = out + j*row_size;
+    for(unsigned int i = 0; i < row_size; ++i)
+      out_row[i] = to_byte(in_row[i]);
+  }
 }
 
 double Gamma::gamma_correct(double value) const
@@ -10,16 +10,50 @@
 class Gamma : public ToneMap
 {
 public:
-  Gamma(double gamma) : exponent(1.0/gamma) { }
+  Gamma(double gamma, float exposure_scale = 1.0f);
 
   virtual void apply(float* data, unsigned int width, unsigned int height, unsigned int channels) const;
   virtual void unapply(float* data, unsigned int width, unsigned int height, unsigned int channels) const;
+  virtual void apply_to_bytes(const float* data, unsigned char* out, unsigned int width, unsigned int height, unsigned int channels) const;
+
+  // Scale applied to values before gamma correction
+  void set_exposure(float exposure_scale);
+
+  // Exposure and gamma correction followed by conversion to 8 bits
+  unsigned char to_byte(float value) const
+  {
+    // Count the thresholds below value starting from the count at the
+    // beginning of its bucket (NaN and negative values give zero)
+    if(!(value > 0.0f))
+      return 0;
+    if(value >= thresholds[254])
+      return 255;
+    // Rounding in value*bucket_scale can give no_of_buckets just below thresholds[254]
+    unsigned int bucket = static_cast<unsigned int>(value*bucket_scale);
+    if(bucket >= no_of_buckets)
+      bucket = no_of_buckets - 1;
+    unsigned int idx = buckets[bucket];
+    while(value >= thresholds[idx])
+      ++idx;
+    return static_cast<unsigned char>(idx);
+  }
 
 protected:
   double gamma_correct(double value) const;
   double gamma_uncorrect(double value) const;
 
   double exponent;
+  float exposure;
+
+  // Linear values where the output byte changes: thresholds[k] maps to k + 0.5
+  // after exposure and gamma correction
+  float thresholds[255];
+
+  // Number of thresholds below the start of each of the equally sized
+  // buckets that divide [0, thresholds[254]]
+  static const unsigned int no_of_buckets = 4096;
+  unsigned char buckets[no_of_buckets];
+  float bucket_scale;
 };
 
 #endif // GAMMA_H
@@ -3,6 +3,7 @@
 // Copyright (c) DTU Informatics 2011
 
 #include <iostream>
+#include <vector>
 #include <optix_world.h>
 #include "../SOIL/SOIL.h"
 #include "int_pow.h"
@@ -13,6 +14,7 @@ using namespace optix;
 
 void HDRTexture::load_hdr(const char* filename)
 {
+  SOIL_free_image_data(data);
   data = SOIL_load_HDR_image(filename, &width, &height, &channels, SOIL_LOAD_AUTO);
   if(!data)
   {
@@ -20,9 +22,14 @@ void HDRTexture::load_hdr(const char* filename)
     return;
   }
   int img_size = width*height;
-  fdata = new float4[img_size];
+  vector<float4> texels(img_size);
   for(int i = 0; i < img_size; ++i)
-    fdata[i] = look_up(i);
+    texels[i] = look_up(i);
+  build_mipmaps(&texels[0], false);
+  SOIL_free_image_data(data);
+  data = 0;
+  if(!opengl)
+    return;
   tex_handle = SOIL_load_OGL_texture(filename, SOIL_LOAD_AUTO, tex_handle, SOIL_FLAG_INVERT_Y);
   if(!glIsTexture(tex_handle))
     cerr << "Error: Could not construct OpenGL texture from loaded image." << endl;
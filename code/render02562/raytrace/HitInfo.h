@@ -9,6 +9,7 @@
 #include "ObjMaterial.h"
 
 class TriMesh;
+class Object3D;
 
 struct HitInfo
 {
@@ -17,7 +18,12 @@ struct HitInfo
       dist(RT_DEFAULT_MAX),
       trace_depth(0),
       material(0),
-      ray_ior(1.0f)
+      ray_ior(1.0f),
+      object(0),
+      prim_idx(0),
+      has_differentials(false),
+      texcoord_dx(optix::make_float2(0.0f)),
+      texcoord_dy(optix::make_float2(0.0f))
   { }
 
   bool has_hit;
@@ -29,6 +35,19 @@ struct HitInfo
   unsigned int trace_depth;
   const ObjMaterial* material;
   float ray_ior;
+
+  // Set by intersection tests. The remaining attributes are filled in by
+  // Object3D::compute_hit_attributes(...) once the closest hit is known.
+  const Object3D* object;
+  unsigned int prim_idx;
+  optix::float2 barycentrics;
+
+  // Ray differentials with respect to image plane x and y (see
+  // ray_differentials.h). They are set before tracing and used to find
+  // the texture footprint of the hit. The footprint is zero otherwise.
+  bool has_differentials;
+  optix::float3 dodx, dody, dddx, dddy;
+  optix::float2 texcoord_dx, texcoord_dy;
 };
 
 #endif // HITINFO_H
\ No newline at end of file
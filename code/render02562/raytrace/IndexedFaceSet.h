@@ -55,6 +55,18 @@ public:
 	/// Return the number of faces.
 	unsigned int no_faces() const { return faces.size(); }
 
+	/// Reserve storage for a number of faces.
+	void reserve_faces(unsigned int n) { faces.reserve(n); }
+
+	/// Remove all faces but keep the vertices.
+	void clear_faces() { faces.clear(); }
+
+	/// Replace all faces by n faces copied from f.
+	void assign_faces(const optix::uint3* f, unsigned int n) { faces.assign(f, f + n); }
+
+	/// Pointer to the contiguous face array.
+	const optix::uint3* face_data() const { return faces.empty() ? 0 : &faces[0]; }
+
 	/// Return the face corresponding to a given index. 
 	const optix::uint3& face(unsigned int idx) const { return faces[idx]; }
 
@@ -79,6 +91,15 @@ public:
 	/// Return the number of vertices.
 	unsigned int no_vertices() const { return verts.size(); }
 
+	/// Reserve storage for a number of vertices.
+	void reserve_vertices(unsigned int n) { verts.reserve(n); }
+
+	/// Replace all vertices by n vertices copied from v.
+	void assign_vertices(const optix::float3* v, unsigned int n) { verts.assign(v, v + n); }
+
+	/// Pointer to the contiguous vertex array.
+	const optix::float3* vertex_data() const { return verts.empty() ? 0 : &verts[0]; }
+
 	/// Return the vertex corresponding to a given index. 
 	const optix::float3& vertex(unsigned int idx) const
 	{
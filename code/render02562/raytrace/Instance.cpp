@@ -0,0 +1,92 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <optix_world.h>
+#include "HitInfo.h"
+#include "Object3D.h"
+#include "Accelerator.h"
+#include "Instance.h"
+
+using namespace optix;
+
+Instance::Instance(const Object3D* instanced_object, const Accelerator* object_acc, const Matrix4x4& instance_transform)
+  : object(instanced_object), acc(object_acc), object_bbox(instanced_object->compute_bbox())
+{
+    set_transform(instance_transform);
+}
+
+bool Instance::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
+{
+    // The object space direction is not normalized, so distances
+    // along the ray are the same in both spaces.
+    Ray ray = to_object_space(r);
+    HitInfo object_hit;
+    if(!acc->closest_hit(ray, object_hit))
+        return false;
+
+    hit.has_hit = true;
+    hit.dist = object_hit.dist;
+    hit.object = this;
+    hit.prim_idx = object_hit.prim_idx;
+    hit.barycentrics = object_hit.barycentrics;
+    return true;
+}
+
+void Instance::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    // Compute the attributes in object space and transform them to world space
+    Ray ray = to_object_space(r);
+    float3 dodx = hit.dodx, dody = hit.dody, dddx = hit.dddx, dddy = hit.dddy;
+    if(hit.has_differentials)
+    {
+        hit.dodx = make_float3(world_to_object*make_float4(dodx, 0.0f));
+        hit.dody = make_float3(world_to_object*make_float4(dody, 0.0f));
+        hit.dddx = make_float3(world_to_object*make_float4(dddx, 0.0f));
+        hit.dddy = make_float3(world_to_object*make_float4(dddy, 0.0f));
+    }
+    object->compute_hit_attributes(ray, hit);
+    hit.dodx = dodx;
+    hit.dody = dody;
+    hit.dddx = dddx;
+    hit.dddy = dddy;
+    hit.object = this;
+    hit.position = r.origin + r.direction*hit.dist;
+    hit.geometric_normal = normalize(make_float3(normal_to_world*make_float4(hit.geometric_normal, 0.0f)));
+    hit.shading_normal = normalize(make_float3(normal_to_world*make_float4(hit.shading_normal, 0.0f)));
+}
+
+void Instance::transform(const Matrix4x4& m)
+{
+    set_transform(m*object_to_world);
+}
+
+void Instance::refit()
+{
+    object_bbox = object->compute_bbox();
+    set_transform(object_to_world);
+}
+
+void Instance::set_transform(const Matrix4x4& m)
+{
+    object_to_world = m;
+    world_to_object = m.inverse();
+    normal_to_world = world_to_object.transpose();
+
+    // Bound the transformed corners of the object space bounding box
+    bbox.invalidate();
+    for(unsigned int i = 0; i < 8; ++i)
+    {
+        float3 corner = make_float3(i & 1 ? object_bbox.m_max.x : object_bbox.m_min.x,
+                                    i & 2 ? object_bbox.m_max.y : object_bbox.m_min.y,
+                                    i & 4 ? object_bbox.m_max.z : object_bbox.m_min.z);
+        bbox.include(make_float3(object_to_world*make_float4(corner, 1.0f)));
+    }
+}
+
+Ray Instance::to_object_space(const Ray& r) const
+{
+    float3 origin = make_float3(world_to_object*make_float4(r.origin, 1.0f));
+    float3 direction = make_float3(world_to_object*make_float4(r.direction, 0.0f));
+    return Ray(origin, direction, r.ray_type, r.tmin, r.tmax);
+}
@@ -0,0 +1,46 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <optix_world.h>
+#include "HitInfo.h"
+#include "Object3D.h"
+#include "Accelerator.h"
+
+// A placement of shared geometry in the scene. The geometry and its
+// acceleration structure are stored once in object space and rays are
+// transformed into object space for intersection. Intersection of the
+// shared geometry must not assume normalized ray directions.
+class Instance : public Object3D
+{
+public:
+  Instance(const Object3D* instanced_object, const Accelerator* object_acc, const optix::Matrix4x4& instance_transform);
+
+  virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int prim_idx) const;
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const;
+  virtual void transform(const optix::Matrix4x4& m);
+  virtual optix::Aabb compute_bbox() const { return bbox; }
+
+  const Object3D* get_object() const { return object; }
+  const optix::Matrix4x4& get_transform() const { return object_to_world; }
+  void set_transform(const optix::Matrix4x4& m);
+
+  // Update the bounding box after the instanced object has changed
+  void refit();
+
+private:
+  optix::Ray to_object_space(const optix::Ray& r) const;
+
+  const Object3D* object;
+  const Accelerator* acc;
+  optix::Matrix4x4 object_to_world;
+  optix::Matrix4x4 world_to_object;
+  optix::Matrix4x4 normal_to_world;
+  optix::Aabb object_bbox;
+  optix::Aabb bbox;
+};
+
+#endif // INSTANCE_H
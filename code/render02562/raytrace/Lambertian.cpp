@@ -4,6 +4,8 @@
 
 #include <optix_world.h>
 #include "HitInfo.h"
+#include "mt_random.h"
+#include "mis_weights.h"
 #include "Lambertian.h"
 
 using namespace optix;
@@ -34,13 +36,17 @@ float3 Lambertian::shade(const Ray& r, HitInfo& hit, bool emit) const
     //
     // Hint: Call the sample function associated with each light in the scene.
 
-    for (int i = 0; i < lights.size(); i++) {
-        Light* light = lights[i];
+    if(heuristic != mis_none)
+        return direct_mis(r, hit) + Emission::shade(r, hit, emit);
+
+    for (unsigned int i = 0; i < no_of_light_picks(); i++) {
+        float weight;
+        const Light* light = pick_light(i, weight);
         float3 dir, Li;
         if (light->sample(hit.position, dir, Li)) {
             float cosine = dot(dir, hit.shading_normal)/(length(dir) + length(hit.shading_normal));
             if (cosine > 0) {
-                result += cosine * Li;
+                result += cosine * Li * weight;
             }
         }
 
@@ -48,3 +54,66 @@ float3 Lambertian::shade(const Ray& r, HitInfo& hit, bool emit) const
 
     return result*rho_d + Emission::shade(r, hit, emit);
 }
+
+float3 Lambertian::direct_mis(const Ray& r, const HitInfo& hit) const
+{
+    float3 result = make_float3(0.0f);
+    const float3& normal = hit.shading_normal;
+    float3 wo = -r.direction;
+    for(unsigned int i = 0; i < no_of_light_picks(); ++i)
+    {
+        float weight;
+        const Light* light = pick_light(i, weight);
+        unsigned int samples = light->get_no_of_samples();
+        float3 L = make_float3(0.0f);
+        for(unsigned int j = 0; j < samples; ++j)
+        {
+            // Sample the light source
+            float3 wi, Li;
+            float light_pdf;
+            if(light->sample_solid_angle(hit.position, wi, Li, light_pdf))
+            {
+                float cos_theta = dot(wi, normal);
+                if(cos_theta > 0.0f)
+                {
+                    float3 f = brdf(hit, wi, wo);
+                    if(light_pdf > 0.0f)
+                        L += f*Li*cos_theta*mis_weight(heuristic, light_pdf, brdf_pdf(hit, wi, wo))/light_pdf;
+                    else
+                        L += f*Li*cos_theta;  // delta light, never found by BRDF sampling
+                }
+            }
+
+            // Sample the BRDF and see if the light source is found in the sampled direction
+            float f_pdf;
+            if(light->has_area() && sample_brdf(hit, wo, wi, f_pdf) && f_pdf > 0.0f)
+            {
+                float cos_theta = dot(wi, normal);
+                if(cos_theta > 0.0f && light->eval_solid_angle(hit.position, wi, Li, light_pdf))
+                    L += brdf(hit, wi, wo)*Li*cos_theta*mis_weight(heuristic, f_pdf, light_pdf)/f_pdf;
+            }
+        }
+        result += L*weight/static_cast<float>(samples);
+    }
+    return result;
+}
+
+float3 Lambertian::brdf(const HitInfo& hit, const float3& wi, const float3& wo) const
+{
+    return get_diffuse(hit)*M_1_PIf;
+}
+
+bool Lambertian::sample_brdf(const HitInfo& hit, const float3& wo, float3& wi, float& pdf) const
+{
+    // Cosine weighted hemisphere sampling
+    cosine_sample_hemisphere(static_cast<float>(mt_random()), static_cast<float>(mt_random()), wi);
+    Onb onb(hit.shading_normal);
+    onb.inverse_transform(wi);
+    pdf = brdf_pdf(hit, wi, wo);
+    return pdf > 0.0f;
+}
+
+float Lambertian::brdf_pdf(const HitInfo& hit, const float3& wi, const float3& wo) const
+{
+    return fmaxf(dot(wi, hit.shading_normal), 0.0f)*M_1_PIf;
+}
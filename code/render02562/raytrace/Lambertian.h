@@ -10,17 +10,49 @@
 #include "ObjMaterial.h"
 #include "HitInfo.h"
 #include "Light.h"
+#include "LightSelector.h"
 #include "Textured.h"
+#include "mis_weights.h"
 
 class Lambertian : public Textured
 {
 public:
-  Lambertian(const std::vector<Light*>& light_vector) : lights(light_vector) { }
+  Lambertian(const std::vector<Light*>& light_vector) : lights(light_vector), light_selector(0), heuristic(mis_none) { }
 
   virtual optix::float3 shade(const optix::Ray& r, HitInfo& hit, bool emit = true) const;
 
+  // Choose mis_balance or mis_power to combine light and BRDF sampling in direct lighting
+  void set_mis(MisHeuristic mis_heuristic) { heuristic = mis_heuristic; }
+  MisHeuristic get_mis() const { return heuristic; }
+
+  // Pick lights by power instead of visiting all lights (null to visit all)
+  void set_light_selector(const LightSelector* selector) { light_selector = selector; }
+
 protected:
+  // Direct lighting estimated by multiple importance sampling
+  optix::float3 direct_mis(const optix::Ray& r, const HitInfo& hit) const;
+
+  // BRDF evaluation and sampling (wi toward the light, wo toward the viewer)
+  virtual optix::float3 brdf(const HitInfo& hit, const optix::float3& wi, const optix::float3& wo) const;
+  virtual bool sample_brdf(const HitInfo& hit, const optix::float3& wo, optix::float3& wi, float& pdf) const;
+  virtual float brdf_pdf(const HitInfo& hit, const optix::float3& wi, const optix::float3& wo) const;
+
+  unsigned int no_of_light_picks() const
+  {
+    return light_selector ? light_selector->get_no_of_picks() : lights.size();
+  }
+
+  const Light* pick_light(unsigned int k, float& weight) const
+  {
+    if(light_selector)
+      return light_selector->pick(k, weight);
+    weight = 1.0f;
+    return lights[k];
+  }
+
   const std::vector<Light*>& lights;
+  const LightSelector* light_selector;
+  MisHeuristic heuristic;
 };
 
 #endif // LAMBERTIAN_H
@@ -6,6 +6,7 @@
 #define LIGHT_H
 
 #include <optix_world.h>
+#include "HitInfo.h"
 
 class RayTracer;
 
@@ -16,9 +17,28 @@ public:
     : tracer(ray_tracer), samples(no_of_samples), shadows(true) 
   { }
 
+  virtual ~Light() { }
+
   virtual bool sample(const optix::float3& pos, optix::float3& dir, optix::float3& L) const = 0;
   virtual bool emit(optix::Ray& r, HitInfo& hit, optix::float3& Phi) const { return false; }
 
+  // Sampling with the solid angle pdf of the returned direction (for multiple importance
+  // sampling). Lights without area are delta distributions and report a pdf of zero.
+  virtual bool sample_solid_angle(const optix::float3& pos, optix::float3& dir, optix::float3& L, float& pdf) const
+  {
+    pdf = 0.0f;
+    return sample(pos, dir, L);
+  }
+
+  // Radiance arriving at pos from the direction dir and the solid angle pdf that
+  // sample_solid_angle(...) would have of generating dir. False if dir misses the light.
+  virtual bool eval_solid_angle(const optix::float3& pos, const optix::float3& dir, optix::float3& L, float& pdf) const { return false; }
+
+  virtual bool has_area() const { return false; }
+
+  // Total emitted power, zero if the light cannot report a finite power
+  virtual optix::float3 get_power() const { return optix::make_float3(0.0f); }
+
   unsigned int get_no_of_samples() const { return samples; }
 
   void toggle_shadows() { shadows = !shadows; }
@@ -0,0 +1,43 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include <optix_world.h>
+#include "mt_random.h"
+#include "Light.h"
+#include "LightSelector.h"
+
+using namespace std;
+using namespace optix;
+
+void LightSelector::build()
+{
+  fixed.clear();
+  indices.clear();
+  vector<float> powers;
+  for(unsigned int i = 0; i < lights.size(); ++i)
+  {
+    float power = luminance(lights[i]->get_power());
+    if(power > 0.0f)
+    {
+      indices.push_back(i);
+      powers.push_back(power);
+    }
+    else
+      fixed.push_back(i);
+  }
+  table.build(powers);
+}
+
+const Light* LightSelector::pick(unsigned int k, float& weight) const
+{
+  if(k < fixed.size())
+  {
+    weight = 1.0f;
+    return lights[fixed[k]];
+  }
+  unsigned int i = table.sample(mt_random_half_open());
+  weight = 1.0f/(picks*table.prob(i));
+  return lights[indices[i]];
+}
@@ -0,0 +1,42 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef LIGHTSELECTOR_H
+#define LIGHTSELECTOR_H
+
+#include <vector>
+#include "AliasTable.h"
+#include "Light.h"
+
+/** Picks a few lights per shading point with probability proportional to
+    their power instead of visiting all of them. Lights that cannot report
+    a finite power (directional lights) are always visited. */
+class LightSelector
+{
+public:
+  LightSelector(const std::vector<Light*>& light_vector, unsigned int no_of_picks = 4)
+    : lights(light_vector), picks(no_of_picks)
+  { }
+
+  /// Tabulate light powers, call when the set of lights is final
+  void build();
+
+  /// True if picking lights means fewer lights per shading point
+  bool is_active() const { return indices.size() > picks; }
+
+  /// Number of lights returned by pick(...) per shading point
+  unsigned int get_no_of_picks() const { return fixed.size() + picks; }
+
+  /// Get light number k (< get_no_of_picks()) and the weight of its contribution
+  const Light* pick(unsigned int k, float& weight) const;
+
+private:
+  const std::vector<Light*>& lights;
+  std::vector<unsigned int> fixed;
+  std::vector<unsigned int> indices;
+  AliasTable table;
+  unsigned int picks;
+};
+
+#endif // LIGHTSELECTOR_H
@@ -0,0 +1,84 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "MappedFile.h"
+
+using namespace std;
+
+MappedFile::MappedFile(const string& filename) : data(0), size(0), opened(false)
+{
+#ifdef _WIN32
+  mapping = 0;
+  file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if(file == INVALID_HANDLE_VALUE)
+    return;
+  LARGE_INTEGER file_size;
+  if(!GetFileSizeEx(file, &file_size))
+    return;
+  size = static_cast<size_t>(file_size.QuadPart);
+  if(size > 0)
+  {
+    mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    if(mapping)
+      data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  }
+#else
+  fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0)
+    return;
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    return;
+  size = static_cast<size_t>(st.st_size);
+  if(size > 0)
+  {
+    void* p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(p != MAP_FAILED)
+    {
+      madvise(p, size, MADV_SEQUENTIAL);
+      data = static_cast<const char*>(p);
+    }
+  }
+#endif
+  opened = size == 0 || data != 0;
+  if(!data)
+    size = 0;
+}
+
+void MappedFile::release(size_t offset, size_t bytes) const
+{
+  if(!data || offset >= size)
+    return;
+  if(bytes > size - offset)
+    bytes = size - offset;
+#ifdef _WIN32
+  // Unlocking pages that are not locked removes them from the working set
+  VirtualUnlock(const_cast<char*>(data + offset), bytes);
+#else
+  // Only whole pages inside the range are released
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t first = (offset + page - 1)/page*page;
+  size_t last = (offset + bytes)/page*page;
+  if(first < last)
+    madvise(const_cast<char*>(data + first), last - first, MADV_DONTNEED);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+  if(data) UnmapViewOfFile(data);
+  if(mapping) CloseHandle(mapping);
+  if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+  if(data) munmap(const_cast<char*>(data), size);
+  if(fd >= 0) close(fd);
+#endif
+}
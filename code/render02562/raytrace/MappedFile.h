@@ -0,0 +1,48 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+  MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  bool is_open() const { return opened; }
+  const char* begin() const { return data; }
+  const char* end() const { return data + size; }
+  size_t get_size() const { return size; }
+
+  /// Let the OS drop the pages of a range from memory. They are read
+  /// from the file again on the next access.
+  void release(size_t offset, size_t bytes) const;
+
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  const char* data;
+  size_t size;
+  bool opened;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int fd;
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,106 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <optix_world.h>
+#include "Scene.h"
+#include "MeshAnimation.h"
+
+using namespace std;
+using namespace optix;
+
+bool MeshAnimation::load(const string& filename)
+{
+    ifstream file(filename.c_str());
+    if(!file)
+    {
+        cerr << "Could not open " << filename << endl;
+        return false;
+    }
+
+    keys.clear();
+    string line;
+    for(unsigned int line_no = 1; getline(file, line); ++line_no)
+    {
+        istringstream in(line);
+        Keyframe key;
+        if(!(in >> key.time))
+        {
+            // Skip comments and blank lines
+            string word;
+            istringstream rest(line);
+            if(rest >> word && word[0] != '#')
+                cerr << filename << "(" << line_no << "): Expected a keyframe time" << endl;
+            continue;
+        }
+        key.transform = Matrix4x4::identity();
+        float* m = key.transform.getData();
+        unsigned int i = 0;
+        if(in >> key.mesh)
+            while(i < 12 && in >> m[i])
+                ++i;
+        if(i < 12)
+        {
+            cerr << filename << "(" << line_no << "): Expected a mesh index and 12 matrix entries" << endl;
+            continue;
+        }
+        keys.push_back(key);
+    }
+    stable_sort(keys.begin(), keys.end());
+    return !keys.empty();
+}
+
+float MeshAnimation::get_start_time() const
+{
+    float time = keys.empty() ? 0.0f : keys.front().time;
+    for(unsigned int i = 1; i < keys.size(); ++i)
+        time = fminf(time, keys[i].time);
+    return time;
+}
+
+float MeshAnimation::get_end_time() const
+{
+    float time = keys.empty() ? 0.0f : keys.front().time;
+    for(unsigned int i = 1; i < keys.size(); ++i)
+        time = fmaxf(time, keys[i].time);
+    return time;
+}
+
+void MeshAnimation::get_keyframe_times(vector<float>& times) const
+{
+    unsigned int first = times.size();
+    for(unsigned int i = 0; i < keys.size(); ++i)
+        times.push_back(keys[i].time);
+    sort(times.begin() + first, times.end());
+    times.erase(unique(times.begin() + first, times.end()), times.end());
+}
+
+void MeshAnimation::set_transforms(float time, Scene& scene) const
+{
+    for(unsigned int first = 0; first < keys.size(); )
+    {
+        // Keyframes of one mesh
+        unsigned int last = first;
+        while(last + 1 < keys.size() && keys[last + 1].mesh == keys[first].mesh)
+            ++last;
+
+        // Find the segment containing the time
+        unsigned int i = first;
+        while(i < last && keys[i + 1].time <= time)
+            ++i;
+        Matrix4x4 transform = keys[i].transform;
+        if(i < last && time > keys[i].time)
+        {
+            float t = (time - keys[i].time)/(keys[i + 1].time - keys[i].time);
+            transform = keys[i].transform*(1.0f - t) + keys[i + 1].transform*t;
+        }
+        scene.set_mesh_transform(keys[first].mesh, transform);
+        first = last + 1;
+    }
+}
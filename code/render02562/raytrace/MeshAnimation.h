@@ -0,0 +1,52 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef MESHANIMATION_H
+#define MESHANIMATION_H
+
+#include <vector>
+#include <string>
+#include <optix_world.h>
+
+class Scene;
+
+// Keyframed mesh transformations read from a text file with one keyframe per line:
+//
+//   time  mesh_index  m00 m01 m02 m03  m10 m11 m12 m13  m20 m21 m22 m23
+//
+// Meshes are numbered in the order they were loaded. The matrix (its first
+// three rows) is applied on top of the transformation the mesh was loaded
+// with. Lines starting with '#' are comments. Matrix entries are interpolated
+// linearly, so rotations between keyframes should be small.
+class MeshAnimation
+{
+public:
+  bool load(const std::string& filename);
+
+  unsigned int get_no_of_keyframes() const { return keys.size(); }
+  float get_start_time() const;
+  float get_end_time() const;
+
+  // Append the distinct keyframe times in increasing order
+  void get_keyframe_times(std::vector<float>& times) const;
+
+  // Move the animated meshes to their positions at the given time. The
+  // scene needs the two-level accelerator, and update_accelerator() must
+  // be called afterwards.
+  void set_transforms(float time, Scene& scene) const;
+
+private:
+  struct Keyframe
+  {
+    float time;
+    unsigned int mesh;
+    optix::Matrix4x4 transform;
+    bool operator<(const Keyframe& k) const { return mesh < k.mesh || (mesh == k.mesh && time < k.time); }
+  };
+
+  // Sorted by mesh and then by time
+  std::vector<Keyframe> keys;
+};
+
+#endif // MESHANIMATION_H
@@ -11,7 +11,9 @@
 class Object3D
 {
 public:
+  virtual ~Object3D() { }
   virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int prim_idx) const = 0;
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const = 0;
   virtual void transform(const optix::Matrix4x4& m) = 0;
   virtual optix::Aabb compute_bbox() const = 0;
   virtual void compute_bsphere(optix::float3& center, float& radius) const
@@ -0,0 +1,93 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include "MappedFile.h"
+#include "OutOfCoreCache.h"
+
+using namespace std;
+
+unsigned int OutOfCoreCache::add_clusters(const MappedFile* file, size_t offset, size_t cluster_bytes, unsigned int no_of_clusters)
+{
+    Segment segment;
+    segment.file = file;
+    segment.offset = offset;
+    segment.cluster_bytes = cluster_bytes;
+    segment.first_cluster = is_resident.size();
+    segments.push_back(segment);
+    is_resident.resize(is_resident.size() + no_of_clusters, 0);
+    referenced.resize(is_resident.size(), 0);
+    return segment.first_cluster;
+}
+
+void OutOfCoreCache::page_in(unsigned int cluster)
+{
+    // Only the bookkeeping needs to be serialized. The mapping stays valid
+    // when a cluster is released, so other threads reading it just cause
+    // its pages to be read from the file again.
+    #pragma omp critical (out_of_core_paging)
+    {
+        if(!is_resident[cluster])
+        {
+            size_t cluster_bytes = get_segment(cluster).cluster_bytes;
+            while(used_memory > 0 && used_memory + cluster_bytes > budget)
+                evict(cluster);
+            #pragma omp atomic write
+            is_resident[cluster] = 1;
+            used_memory += cluster_bytes;
+            ++page_ins;
+        }
+    }
+}
+
+void OutOfCoreCache::evict(unsigned int keep)
+{
+    // The clock hand clears the reference bits it passes and evicts the first
+    // resident cluster without one. A released cluster with its bit set was
+    // read by a thread racing with its eviction, which may have faulted its
+    // pages back in, so it is released again. Should readers keep setting
+    // the bits, the hand evicts regardless after two turns.
+    unsigned int no_of_clusters = is_resident.size();
+    for(unsigned int steps = 0; ; ++steps)
+    {
+        unsigned int cluster = hand;
+        hand = (hand + 1)%no_of_clusters;
+        if(cluster == keep)
+            continue;
+
+        unsigned char flag;
+        #pragma omp atomic read
+        flag = referenced[cluster];
+        if(flag && steps < 2*no_of_clusters)
+        {
+            #pragma omp atomic write
+            referenced[cluster] = 0;
+            if(!is_resident[cluster])
+                release(cluster);
+        }
+        else if(is_resident[cluster])
+        {
+            #pragma omp atomic write
+            is_resident[cluster] = 0;
+            release(cluster);
+            used_memory -= get_segment(cluster).cluster_bytes;
+            return;
+        }
+    }
+}
+
+void OutOfCoreCache::release(unsigned int cluster) const
+{
+    const Segment& s = get_segment(cluster);
+    s.file->release(s.offset + (cluster - s.first_cluster)*s.cluster_bytes, s.cluster_bytes);
+}
+
+const OutOfCoreCache::Segment& OutOfCoreCache::get_segment(unsigned int cluster) const
+{
+    // A scene has few out-of-core meshes, so the segments are searched linearly
+    unsigned int i = segments.size() - 1;
+    while(segments[i].first_cluster > cluster)
+        --i;
+    return segments[i];
+}
@@ -0,0 +1,76 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef OUTOFCORECACHE_H
+#define OUTOFCORECACHE_H
+
+#include <vector>
+#include "MappedFile.h"
+
+/** Paging state shared by the out-of-core meshes of a scene (see
+    OutOfCoreMesh), so that one memory budget bounds the clusters resident
+    across all meshes. A cluster is paged in when one of its triangles is
+    accessed. When the resident clusters exceed the budget, a single clock
+    hand sweeps the clusters of all meshes and releases those that were
+    not referenced since it last passed them (second chance replacement). */
+class OutOfCoreCache
+{
+public:
+  OutOfCoreCache(size_t memory_budget = 0) : budget(memory_budget), used_memory(0), hand(0), page_ins(0) { }
+
+  void set_budget(size_t memory_budget) { budget = memory_budget; }
+  size_t get_budget() const { return budget; }
+  size_t get_used_memory() const { return used_memory; }
+  unsigned int get_page_ins() const { return page_ins; }
+  unsigned int get_no_of_clusters() const { return is_resident.size(); }
+
+  // Register the clusters of a mapped file before rendering. The clusters are
+  // cluster_bytes long and start at offset. Returns the index of the first one.
+  // The file must stay open as long as the cache is used.
+  unsigned int add_clusters(const MappedFile* file, size_t offset, size_t cluster_bytes, unsigned int no_of_clusters);
+
+  // Set the reference bit of a cluster and page it in if it is not resident
+  void use(unsigned int cluster)
+  {
+    unsigned char flag;
+    #pragma omp atomic read
+    flag = referenced[cluster];
+    if(!flag)
+    {
+      #pragma omp atomic write
+      referenced[cluster] = 1;
+    }
+    #pragma omp atomic read
+    flag = is_resident[cluster];
+    if(!flag)
+      page_in(cluster);
+  }
+
+private:
+  void page_in(unsigned int cluster);
+  void evict(unsigned int keep);
+  void release(unsigned int cluster) const;
+
+  // The clusters of each registered file are numbered from first_cluster
+  struct Segment
+  {
+    const MappedFile* file;
+    size_t offset;
+    size_t cluster_bytes;
+    unsigned int first_cluster;
+  };
+  const Segment& get_segment(unsigned int cluster) const;
+  std::vector<Segment> segments;
+
+  // Residency and the clock hand are only changed inside page_in(...).
+  // Readers set the reference bits without ordering.
+  size_t budget;
+  size_t used_memory;
+  std::vector<unsigned char> is_resident;
+  std::vector<unsigned char> referenced;
+  unsigned int hand;
+  unsigned int page_ins;
+};
+
+#endif // OUTOFCORECACHE_H
@@ -0,0 +1,553 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <optix_world.h>
+#include "HitInfo.h"
+#include "TriMesh.h"
+#include "Bvh.h"
+#include "MappedFile.h"
+#include "binary_io.h"
+#include "obj_load.h"
+#include "OutOfCoreMesh.h"
+#include "ray_differentials.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+    // Bump the version whenever the layout of the file changes
+    const char ooc_magic[8] = { '0', '2', '5', '6', '2', 'O', 'O', 'C' };
+    const unsigned int ooc_version = 2;
+
+    // Triangles per cluster (about 64 KB of triangle data)
+    const unsigned int default_cluster_size = 640;
+
+    // Triangles per leaf of the hierarchy stored with each cluster
+    const unsigned int cluster_leaf_size = 4;
+    const unsigned int max_cluster_depth = 32;
+
+    // Nodes of the hierarchy over a cluster of n triangles (split at the median)
+    unsigned int no_of_cluster_nodes(unsigned int n)
+    {
+        return n <= cluster_leaf_size ? 1 : 1 + no_of_cluster_nodes(n/2) + no_of_cluster_nodes(n - n/2);
+    }
+
+    bool intersect_bbox(const Aabb& bbox, const Ray& r, const float3& inv_dir, float& t)
+    {
+        float3 p1 = (bbox.m_min - r.origin)*inv_dir;
+        float3 p2 = (bbox.m_max - r.origin)*inv_dir;
+        float tmin = fmaxf(fminf(p1, p2));
+        float tmax = fminf(fmaxf(p1, p2));
+        t = tmin;
+        return tmin <= tmax && tmin <= r.tmax && tmax >= r.tmin;
+    }
+
+    // Triangle data starts at a page boundary
+    const size_t data_alignment = 4096;
+
+    unsigned int expand_bits(unsigned int x)
+    {
+        x = (x*0x00010001u) & 0xFF0000FFu;
+        x = (x*0x00000101u) & 0x0F00F00Fu;
+        x = (x*0x00000011u) & 0xC30C30C3u;
+        x = (x*0x00000005u) & 0x49249249u;
+        return x;
+    }
+
+    // 30-bit Morton code of a point in the unit cube
+    unsigned int morton_code(const float3& p)
+    {
+        float3 q = fminf(fmaxf(p*1024.0f, make_float3(0.0f)), make_float3(1023.0f));
+        return (expand_bits(static_cast<unsigned int>(q.x)) << 2) 
+             | (expand_bits(static_cast<unsigned int>(q.y)) << 1) 
+             |  expand_bits(static_cast<unsigned int>(q.z));
+    }
+
+    struct MortonFace
+    {
+        unsigned int code;
+        unsigned int idx;
+        bool operator<(const MortonFace& f) const { return code < f.code || (code == f.code && idx < f.idx); }
+    };
+
+    // Add the angle weighted normal of a triangle to its vertices as done by TriMesh::compute_normals()
+    void add_vertex_normals(const IndexedFaceSet& geometry, const uint3& f, vector<float3>& normals)
+    {
+        const float3& p0 = geometry.vertex(f.x);
+        float3 face_normal = cross(geometry.vertex(f.y) - p0, geometry.vertex(f.z) - p0);
+        float len = dot(face_normal, face_normal);
+        if(len > 0.0f)
+            face_normal /= sqrt(len);
+
+        const unsigned int* fp = &f.x;
+        for(int j = 0; j < 3; ++j)
+        {
+            const float3& p = geometry.vertex(fp[j]);
+            float3 a = geometry.vertex(fp[(j + 1)%3]) - p;
+            float len_a = dot(a, a);
+            if(len_a > 0.0f)
+                a /= sqrt(len_a);
+            float3 b = geometry.vertex(fp[(j + 2)%3]) - p;
+            float len_b = dot(b, b);
+            if(len_b > 0.0f)
+                b /= sqrt(len_b);
+            float d = fmaxf(-1.0f, fminf(1.0f, dot(a, b)));
+            normals[fp[j]] += face_normal*acos(d);
+        }
+    }
+
+    bool is_emissive(const ObjMaterial& mat)
+    {
+        return mat.name != "default" && (mat.ambient[0] > 0.0f || mat.ambient[1] > 0.0f || mat.ambient[2] > 0.0f);
+    }
+}
+
+OutOfCoreMesh::OutOfCoreMesh(const string& filename, const string& source, const Matrix4x4& transform, OutOfCoreCache* cluster_cache)
+    : file(0), data_offset(0), cluster_bytes(0), no_of_faces(0), cluster_size(default_cluster_size),
+      has_normals(false), has_texcoords(false), cache(cluster_cache), first_cluster(0)
+{
+    MappedFile* mapped = new MappedFile(filename);
+    if(!mapped->is_open())
+    {
+        delete mapped;
+        return;
+    }
+    BinaryReader in(mapped->begin(), mapped->end());
+
+    // Header
+    char magic[sizeof(ooc_magic)];
+    in.read(magic, sizeof(magic));
+    bool valid = in.good() && memcmp(magic, ooc_magic, sizeof(magic)) == 0 && in.read<unsigned int>() == ooc_version;
+    float m[16];
+    in.read(m, sizeof(m));
+    valid = valid && in.good() && memcmp(m, transform.getData(), sizeof(m)) == 0;
+    valid = valid && in.read_string() == source;
+    SourceInfo info = in.read<SourceInfo>();
+    valid = valid && in.good() && is_source_unchanged(source, info);
+    if(!valid)
+    {
+        delete mapped;
+        return;
+    }
+
+    unsigned int no_of_materials = in.read<unsigned int>();
+    materials.resize(in.good() ? no_of_materials : 0);
+    for(unsigned int i = 0; i < materials.size(); ++i)
+        read_material(in, materials[i]);
+    has_normals = in.read<unsigned char>() != 0;
+    has_texcoords = in.read<unsigned char>() != 0;
+    no_of_faces = in.read<unsigned int>();
+    cluster_size = in.read<unsigned int>();
+    unsigned int nodes_per_cluster = in.read<unsigned int>();
+    bbox = in.read<Aabb>();
+    in.read_vector(cluster_bounds);
+    cluster_bytes = cluster_size*sizeof(Face) + nodes_per_cluster*sizeof(BvhNode);
+    data_offset = (in.position() - mapped->begin() + data_alignment - 1)/data_alignment*data_alignment;
+    if(!in.good() || cluster_size == 0 || cluster_bounds.size() != (no_of_faces + cluster_size - 1)/cluster_size
+       || mapped->get_size() != data_offset + cluster_bounds.size()*cluster_bytes)
+    {
+        cluster_bounds.clear();
+        delete mapped;
+        return;
+    }
+
+    file = mapped;
+    first_cluster = cache->add_clusters(file, data_offset, cluster_bytes, cluster_bounds.size());
+
+    // Nothing is resident until it is accessed
+    file->release(0, file->get_size());
+}
+
+OutOfCoreMesh::~OutOfCoreMesh()
+{
+    delete file;
+}
+
+// Receives the triangles streamed from the source and writes them chunk by
+// chunk to a temporary file, each chunk sorted along a Morton curve. The
+// vertex indices are kept for computing normals if the source has none.
+// The bounds of the clusters that the triangles will be stored in are
+// found on the way.
+class OutOfCoreMesh::Converter : public ObjStream
+{
+public:
+    struct StreamedFace
+    {
+        Face face;
+        uint3 g;
+    };
+
+    Converter(FILE* out, const Matrix4x4& m)
+        : faces_out(out), transform(m), no_of_faces(0), has_normals(false), has_texcoords(false)
+    { }
+
+    virtual void add_triangles(const TriMesh& mesh);
+
+    // Build the hierarchy over the triangles of a cluster. The triangles are
+    // reordered, so that each leaf refers to a range of them.
+    static void build_hierarchy(vector<Face>& faces, vector<BvhNode>& nodes);
+
+    FILE* faces_out;
+    Matrix4x4 transform;
+    unsigned int no_of_faces;
+    bool has_normals;
+    bool has_texcoords;
+    vector<Aabb> cluster_bounds;
+
+private:
+    static void subdivide(vector<Face>& faces, vector<BvhNode>& nodes, unsigned int node_idx, unsigned int first, unsigned int count);
+
+    struct CentroidLess
+    {
+        CentroidLess(unsigned int split_axis) : axis(split_axis) { }
+        bool operator()(const Face& a, const Face& b) const
+        {
+            return (&a.v[0].x)[axis] + (&a.v[1].x)[axis] + (&a.v[2].x)[axis] < (&b.v[0].x)[axis] + (&b.v[1].x)[axis] + (&b.v[2].x)[axis];
+        }
+        unsigned int axis;
+    };
+};
+
+void OutOfCoreMesh::Converter::add_triangles(const TriMesh& mesh)
+{
+    unsigned int n = mesh.geometry.no_faces();
+    vector<StreamedFace> chunk(n);
+    vector<float3> centroids(n);
+    Aabb centroid_bbox;
+    for(unsigned int i = 0; i < n; ++i)
+    {
+        StreamedFace& f = chunk[i];
+        memset(&f, 0, sizeof(f));
+        f.g = mesh.geometry.face(i);
+        const unsigned int* g = &f.g.x;
+        const unsigned int* nf = i < mesh.normals.no_faces() ? &mesh.normals.face(i).x : 0;
+        const unsigned int* t = i < mesh.texcoords.no_faces() ? &mesh.texcoords.face(i).x : 0;
+        for(unsigned int j = 0; j < 3; ++j)
+        {
+            f.face.v[j] = make_float3(transform*make_float4(mesh.geometry.vertex(g[j]), 1.0f));
+            if(nf)
+                f.face.n[j] = make_float3(transform*make_float4(mesh.normals.vertex(nf[j]), 0.0f));
+            if(t)
+                f.face.t[j] = make_float2(mesh.texcoords.vertex(t[j]));
+        }
+        f.face.material = mesh.mat_idx[i];
+        centroids[i] = (f.face.v[0] + f.face.v[1] + f.face.v[2])/3.0f;
+        centroid_bbox.include(centroids[i]);
+    }
+
+    float3 extent = fmaxf(centroid_bbox.extent(), make_float3(1.0e-12f));
+    vector<MortonFace> order(n);
+    for(unsigned int i = 0; i < n; ++i)
+    {
+        order[i].code = morton_code((centroids[i] - centroid_bbox.m_min)/extent);
+        order[i].idx = i;
+    }
+    sort(order.begin(), order.end());
+    for(unsigned int i = 0; i < n; ++i)
+    {
+        const StreamedFace& f = chunk[order[i].idx];
+        write_value(faces_out, f);
+        unsigned int cluster = (no_of_faces + i)/default_cluster_size;
+        if(cluster == cluster_bounds.size())
+            cluster_bounds.push_back(Aabb());
+        for(unsigned int j = 0; j < 3; ++j)
+            cluster_bounds[cluster].include(f.face.v[j]);
+    }
+
+    no_of_faces += n;
+    has_normals = has_normals || mesh.has_normals();
+    has_texcoords = has_texcoords || mesh.texcoords.no_faces() > 0;
+}
+
+void OutOfCoreMesh::Converter::build_hierarchy(vector<Face>& faces, vector<BvhNode>& nodes)
+{
+    nodes.assign(1, BvhNode());
+    subdivide(faces, nodes, 0, 0, faces.size());
+}
+
+void OutOfCoreMesh::Converter::subdivide(vector<Face>& faces, vector<BvhNode>& nodes, unsigned int node_idx, unsigned int first, unsigned int count)
+{
+    Aabb bbox, centroid_bbox;
+    for(unsigned int i = first; i < first + count; ++i)
+    {
+        const Face& f = faces[i];
+        bbox.include(f.v[0]);
+        bbox.include(f.v[1]);
+        bbox.include(f.v[2]);
+        centroid_bbox.include((f.v[0] + f.v[1] + f.v[2])/3.0f);
+    }
+    nodes[node_idx].bbox = bbox;
+    if(count <= cluster_leaf_size)
+    {
+        nodes[node_idx].first = first;
+        nodes[node_idx].count = count;
+        return;
+    }
+
+    // Split at the median along the largest centroid extent, so that the
+    // number of nodes only depends on the number of triangles
+    float3 extent = centroid_bbox.extent();
+    unsigned int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    unsigned int half = count/2;
+    nth_element(faces.begin() + first, faces.begin() + first + half, faces.begin() + first + count, CentroidLess(axis));
+    unsigned int left = nodes.size();
+    nodes[node_idx].first = left;
+    nodes[node_idx].count = 0;
+    nodes.resize(nodes.size() + 2);
+    subdivide(faces, nodes, left, first, half);
+    subdivide(faces, nodes, left + 1, first + half, count - half);
+}
+
+bool OutOfCoreMesh::convert(const string& filename, const string& source, const Matrix4x4& transform)
+{
+    // The header needs the materials and the bounding box of the whole mesh,
+    // so the triangles are first written to a temporary file
+    string faces_file = filename + ".faces.tmp";
+    FILE* faces_out = fopen(faces_file.c_str(), "w+b");
+    if(!faces_out)
+    {
+        cerr << "Could not write out-of-core mesh " << filename << endl;
+        return false;
+    }
+    TriMesh mesh;
+    Converter converter(faces_out, transform);
+    obj_stream(source, mesh, converter);
+    unsigned int no_of_faces = converter.no_of_faces;
+
+    // Vertex normals for a source without normals
+    vector<float3> normals;
+    if(!converter.has_normals)
+    {
+        cout << "Computing normals" << endl;
+        normals.resize(mesh.geometry.no_vertices(), make_float3(0.0f));
+        rewind(faces_out);
+        Converter::StreamedFace f;
+        for(unsigned int i = 0; i < no_of_faces && fread(&f, sizeof(f), 1, faces_out) == 1; ++i)
+            add_vertex_normals(mesh.geometry, f.g, normals);
+        for(unsigned int i = 0; i < normals.size(); ++i)
+        {
+            float len_normal = dot(normals[i], normals[i]);
+            if(len_normal > 0.0f)
+                normals[i] /= sqrt(len_normal);
+            normals[i] = make_float3(transform*make_float4(normals[i], 0.0f));
+        }
+    }
+
+    string tmp_file = filename + ".tmp";
+    FILE* out = fopen(tmp_file.c_str(), "wb");
+    if(!out)
+    {
+        fclose(faces_out);
+        remove(faces_file.c_str());
+        cerr << "Could not write out-of-core mesh " << filename << endl;
+        return false;
+    }
+
+    // Header
+    SourceInfo info;
+    get_source_info(source, info);
+    Aabb bbox;
+    for(unsigned int i = 0; i < mesh.geometry.no_vertices(); ++i)
+        bbox.include(make_float3(transform*make_float4(mesh.geometry.vertex(i), 1.0f)));
+    bool has_normals = converter.has_normals || !normals.empty();
+    write_bytes(out, ooc_magic, sizeof(ooc_magic));
+    write_value(out, ooc_version);
+    write_bytes(out, transform.getData(), 16*sizeof(float));
+    write_string(out, source);
+    write_value(out, info);
+    write_value(out, static_cast<unsigned int>(mesh.materials.size()));
+    for(unsigned int i = 0; i < mesh.materials.size(); ++i)
+        write_material(out, mesh.materials[i]);
+    write_value(out, static_cast<unsigned char>(has_normals));
+    write_value(out, static_cast<unsigned char>(converter.has_texcoords));
+    unsigned int nodes_per_cluster = no_of_cluster_nodes(default_cluster_size);
+    write_value(out, no_of_faces);
+    write_value(out, default_cluster_size);
+    write_value(out, nodes_per_cluster);
+    write_value(out, bbox);
+    write_vector(out, converter.cluster_bounds);
+    long header_size = ftell(out);
+    vector<char> padding((data_alignment - header_size%data_alignment)%data_alignment, 0);
+    if(!padding.empty())
+        write_bytes(out, &padding[0], padding.size());
+
+    // Clusters of triangles, each followed by its hierarchy. The last
+    // cluster is padded, so that all clusters have the same size.
+    rewind(faces_out);
+    Converter::StreamedFace f;
+    Face no_face;
+    memset(&no_face, 0, sizeof(no_face));
+    vector<Face> cluster;
+    vector<BvhNode> nodes;
+    unsigned int copied = 0;
+    while(copied < no_of_faces && fread(&f, sizeof(f), 1, faces_out) == 1)
+    {
+        if(!normals.empty())
+            for(unsigned int j = 0; j < 3; ++j)
+                f.face.n[j] = normals[(&f.g.x)[j]];
+        cluster.push_back(f.face);
+        if(++copied%default_cluster_size == 0 || copied == no_of_faces)
+        {
+            Converter::build_hierarchy(cluster, nodes);
+            cluster.resize(default_cluster_size, no_face);
+            nodes.resize(nodes_per_cluster);
+            write_bytes(out, &cluster[0], cluster.size()*sizeof(Face));
+            write_bytes(out, &nodes[0], nodes.size()*sizeof(BvhNode));
+            cluster.clear();
+        }
+    }
+    fclose(faces_out);
+    remove(faces_file.c_str());
+
+    if(copied != no_of_faces)
+    {
+        fclose(out);
+        remove(tmp_file.c_str());
+        cerr << "Could not write out-of-core mesh " << filename << endl;
+        return false;
+    }
+    if(!commit_file(out, tmp_file, filename))
+    {
+        cerr << "Could not write out-of-core mesh " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+bool OutOfCoreMesh::intersect(const Ray& r, HitInfo& hit, unsigned int cluster) const
+{
+    const Face* faces = get_cluster(cluster);
+    const BvhNode* nodes = reinterpret_cast<const BvhNode*>(faces + cluster_size);
+    Ray ray = r;
+    float3 inv_dir = make_float3(1.0f)/ray.direction;
+    float t;
+    if(!intersect_bbox(nodes[0].bbox, ray, inv_dir, t))
+        return false;
+
+    // Visit the nearest child first as in Bvh::intersect_nodes(...)
+    unsigned int stack[max_cluster_depth];
+    unsigned int stack_size = 0;
+    unsigned int node_idx = 0;
+    bool found = false;
+    for(;;)
+    {
+        const BvhNode& node = nodes[node_idx];
+        if(node.count > 0)
+        {
+            for(unsigned int i = node.first; i < node.first + node.count; ++i)
+            {
+                const Face& face = faces[i];
+                float3 normal;
+                float dist, v, w;
+                if(optix::intersect_triangle(ray, face.v[0], face.v[1], face.v[2], normal, dist, v, w))
+                {
+                    ray.tmax = dist;
+                    hit.has_hit = true;
+                    hit.dist = dist;
+                    hit.object = this;
+                    hit.prim_idx = cluster*cluster_size + i;
+                    hit.barycentrics = make_float2(v, w);
+                    found = true;
+                }
+            }
+        }
+        else
+        {
+            float t_left, t_right;
+            bool left = intersect_bbox(nodes[node.first].bbox, ray, inv_dir, t_left);
+            bool right = intersect_bbox(nodes[node.first + 1].bbox, ray, inv_dir, t_right);
+            if(left && right)
+            {
+                bool left_first = t_left <= t_right;
+                stack[stack_size++] = left_first ? node.first + 1 : node.first;
+                node_idx = left_first ? node.first : node.first + 1;
+                continue;
+            }
+            if(left || right)
+            {
+                node_idx = left ? node.first : node.first + 1;
+                continue;
+            }
+        }
+
+        // Pop nodes that are still in front of the closest hit
+        bool next = false;
+        while(stack_size > 0 && !next)
+        {
+            node_idx = stack[--stack_size];
+            next = intersect_bbox(nodes[node_idx].bbox, ray, inv_dir, t);
+        }
+        if(!next)
+            break;
+    }
+    return found;
+}
+
+void OutOfCoreMesh::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    const Face& face = get_face(hit.prim_idx);
+    float v = hit.barycentrics.x;
+    float w = hit.barycentrics.y;
+    hit.geometric_normal = normalize(cross(face.v[1] - face.v[0], face.v[2] - face.v[0]));
+    if(has_normals)
+        hit.shading_normal = normalize((1-v-w)*face.n[0] + v*face.n[1] + w*face.n[2]);
+    else
+        hit.shading_normal = hit.geometric_normal;
+    if(has_texcoords)
+    {
+        hit.texcoord = make_float3((1-v-w)*face.t[0] + v*face.t[1] + w*face.t[2], 1.0f);
+        compute_texcoord_differentials(r, hit, face.v[0], face.v[1], face.v[2], face.t[0], face.t[1], face.t[2]);
+    }
+    hit.material = &materials[face.material];
+    hit.position = r.origin + r.direction*hit.dist;
+}
+
+void OutOfCoreMesh::transform(const Matrix4x4& m)
+{
+    // The mapped file is read-only. Transformations are applied when the file is written.
+    cerr << "Out-of-core meshes cannot be transformed after loading" << endl;
+}
+
+void OutOfCoreMesh::extract_emissive(TriMesh& mesh) const
+{
+    for(unsigned int i = 0; i < no_of_faces; ++i)
+    {
+        const Face& face = get_face(i);
+        const ObjMaterial& mat = materials[face.material];
+        if(!is_emissive(mat))
+            continue;
+
+        uint3 g_face;
+        for(unsigned int j = 0; j < 3; ++j)
+            (&g_face.x)[j] = mesh.geometry.add_vertex(face.v[j]);
+        int idx = mesh.geometry.add_face(g_face);
+        if(has_normals)
+        {
+            uint3 n_face;
+            for(unsigned int j = 0; j < 3; ++j)
+                (&n_face.x)[j] = mesh.normals.add_vertex(face.n[j]);
+            mesh.normals.add_face(n_face, idx);
+        }
+        if(has_texcoords)
+        {
+            uint3 t_face;
+            for(unsigned int j = 0; j < 3; ++j)
+                (&t_face.x)[j] = mesh.texcoords.add_vertex(make_float3(face.t[j], 1.0f));
+            mesh.texcoords.add_face(t_face, idx);
+        }
+
+        unsigned int k = 0;
+        while(k < mesh.materials.size() && mesh.materials[k].name != mat.name)
+            ++k;
+        if(k == mesh.materials.size())
+            mesh.materials.push_back(mat);
+        mesh.mat_idx.push_back(k);
+    }
+}
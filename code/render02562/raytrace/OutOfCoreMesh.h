@@ -0,0 +1,98 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef OUTOFCOREMESH_H
+#define OUTOFCOREMESH_H
+
+#include <string>
+#include <vector>
+#include <optix_world.h>
+#include "ObjMaterial.h"
+#include "HitInfo.h"
+#include "Object3D.h"
+#include "TriMesh.h"
+#include "MappedFile.h"
+#include "Bvh.h"
+#include "OutOfCoreCache.h"
+
+/** \brief Triangle mesh that stays in a memory-mapped file.
+
+    Triangles are stored in clusters of nearby triangles (sorted along a
+    Morton curve). The primitives seen by accelerators are the clusters,
+    whose bounds are kept in memory, so an accelerator has one entry per
+    cluster and building it pages nothing in. The triangles of a cluster
+    are stored with a small bounding volume hierarchy over them, which is
+    paged in and released with the triangles by an OutOfCoreCache that all
+    out-of-core meshes of a scene share. Memory that is not paged is the
+    cluster bounds and the accelerator entries, about 64 bytes per cluster
+    of 640 triangles. */
+class OutOfCoreMesh : public Object3D
+{
+public:
+  /// Map a file written by convert(...) for the same source and transformation
+  /// and register its clusters with the cache, which must outlive the mesh
+  OutOfCoreMesh(const std::string& filename, const std::string& source, const optix::Matrix4x4& transform, OutOfCoreCache* cluster_cache);
+  virtual ~OutOfCoreMesh();
+
+  bool is_open() const { return file != 0; }
+
+  /// Convert the OBJ file source to an out-of-core mesh file. The triangles
+  /// are streamed from the source, so only its vertices are kept in memory.
+  static bool convert(const std::string& filename, const std::string& source, const optix::Matrix4x4& transform);
+
+  /// Closest hit with the triangles of a cluster. The index of the triangle
+  /// that was hit is returned in hit.prim_idx.
+  virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int cluster) const;
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const;
+  virtual void transform(const optix::Matrix4x4& m);
+  virtual optix::Aabb compute_bbox() const { return bbox; }
+  virtual unsigned int get_no_of_primitives() const { return cluster_bounds.size(); }
+  virtual optix::Aabb get_primitive_bbox(unsigned int cluster) const { return cluster_bounds[cluster]; }
+
+  unsigned int get_no_of_faces() const { return no_of_faces; }
+
+  /// Copy the triangles that have an emissive material into a mesh
+  void extract_emissive(TriMesh& mesh) const;
+
+  const std::vector<ObjMaterial>& get_materials() const { return materials; }
+  std::vector<ObjMaterial>& get_materials() { return materials; }
+
+private:
+  class Converter;
+
+  // Triangle with its vertex attributes as stored in the file
+  struct Face
+  {
+    optix::float3 v[3];
+    optix::float3 n[3];
+    optix::float2 t[3];
+    unsigned int material;
+  };
+
+  // The triangles of a cluster are followed by the nodes of its hierarchy
+  const Face* get_cluster(unsigned int cluster) const
+  {
+    cache->use(first_cluster + cluster);
+    return reinterpret_cast<const Face*>(file->begin() + data_offset + cluster*cluster_bytes);
+  }
+  const Face& get_face(unsigned int face_idx) const
+  {
+    return get_cluster(face_idx/cluster_size)[face_idx%cluster_size];
+  }
+
+  MappedFile* file;
+  size_t data_offset;
+  size_t cluster_bytes;
+  unsigned int no_of_faces;
+  unsigned int cluster_size;
+  bool has_normals;
+  bool has_texcoords;
+  optix::Aabb bbox;
+  std::vector<optix::Aabb> cluster_bounds;
+  std::vector<ObjMaterial> materials;
+  OutOfCoreCache* cache;
+  unsigned int first_cluster;
+};
+
+#endif // OUTOFCOREMESH_H
@@ -9,6 +9,7 @@
 #include "HitInfo.h"
 #include "ObjMaterial.h"
 #include "mt_random.h"
+#include "RenderStats.h"
 #include "ParticleTracer.h"
 
 #ifdef _OPENMP
@@ -32,11 +33,16 @@ void ParticleTracer::build_maps(int no_of_caustic_particles, unsigned int max_no
         no_of_caustic_particles = caustics.get_max_photon_count();
     }
 
+    // Discard photons from a previous build
+    caustics.clear();
+
     // Choose block size
     int block = std::max(1, no_of_caustic_particles/100);
 
     // Shoot particles
     unsigned int nshots = 0;
+    particles_traced = 0;
+    particle_bounces = 0;
     unsigned int caustics_done = no_of_caustic_particles == 0 ? 1 : 0;
     while(!caustics_done)
     {
@@ -66,6 +72,10 @@ void ParticleTracer::build_maps(int no_of_caustic_particles, unsigned int max_no
             caustics_done = nshots;
     }
     cout << "Particles in caustics map: " << caustics.get_photon_count() << endl;
+    if(particles_traced > 0)
+        cout << "Average particle path length: " << particle_bounces/static_cast<double>(particles_traced) << endl;
+    if(nshots > 0)
+        cout << "Photons stored per shot: " << caustics.get_photon_count()/static_cast<double>(nshots) << endl;
 
     // Finalize photon maps
     caustics.scale_photon_power(lights.size()/static_cast<float>(caustics_done));
@@ -74,6 +84,7 @@ void ParticleTracer::build_maps(int no_of_caustic_particles, unsigned int max_no
 
 float3 ParticleTracer::caustics_irradiance(const HitInfo& hit, float max_distance, int no_of_particles)
 {
+    render_stats.add(RenderStats::photon_lookups);
     return caustics.irradiance_estimate(hit.position, hit.shading_normal, max_distance, no_of_particles);
 }
 
@@ -91,14 +102,19 @@ void ParticleTracer::trace_particle(const Light* light, const unsigned int caust
     Ray r;
     HitInfo hit;
     float3 Phi;
+    render_stats.add(RenderStats::photon_rays);
     if (!light->emit(r, hit, Phi)) {
         // If no hit at all
         return;
     }
+    float Phi_max = fmaxf(Phi);
+    ++particles_traced;
 
     // Forward from all specular surfaces
-    while(scene->is_specular(hit.material) && hit.trace_depth < 500)
+    while(scene->is_specular(hit.material) && hit.trace_depth < max_depth)
     {
+        ++particle_bounces;
+
         switch(hit.material->illum)
         {
             case 3:  // mirror materials
@@ -118,7 +134,21 @@ void ParticleTracer::trace_particle(const Light* light, const unsigned int caust
             {
                 // If went through a volume (same direction as material normal)
                 if (dot(r.direction, hit.geometric_normal) > 0) {
-                    Phi = Phi*get_transmittance(hit);
+                    float3 T = get_transmittance(hit);
+                    if (russian_roulette) {
+                        // Survive with the largest transmittance so that surviving
+                        // particles keep their power instead of fading out
+                        float P = fmaxf(T);
+                        if (mt_random() >= P) {
+                            return;
+                        }
+                        Phi = Phi*T/P;
+                    } else {
+                        Phi = Phi*T;
+                        if (fmaxf(Phi) < min_throughput*Phi_max) {
+                            return;
+                        }
+                    }
                 }
             }
             case 2:  // glossy materials
@@ -149,6 +179,11 @@ void ParticleTracer::trace_particle(const Light* light, const unsigned int caust
         }
     }
 
+    // Paths cut off by the depth limit did not reach a diffuse surface
+    if (scene->is_specular(hit.material)) {
+        return;
+    }
+
     // Store in caustics map at first diffuse surface
     // Hint: When storing, the convention is that the photon direction
     //       should point back toward where the photon came from.
@@ -19,10 +19,19 @@ public:
                  Scene* s, 
                  unsigned int max_no_of_particles,
                  unsigned int pixel_subdivs = 1)
-    : RayTracer(w, h, s, pixel_subdivs), caustics(max_no_of_particles)
+    : RayTracer(w, h, s, pixel_subdivs), caustics(max_no_of_particles),
+      max_depth(500), russian_roulette(true), min_throughput(1.0e-3f),
+      particles_traced(0), particle_bounces(0)
   { }
 
   void build_maps(int no_of_caustic_particles, unsigned int max_no_of_shots = 500000);
+
+  // Particle path termination: maximum number of specular bounces, Russian roulette
+  // on absorption, and (without Russian roulette) the lowest fraction of the emitted
+  // power that a particle may carry before it is discarded.
+  void set_max_particle_depth(unsigned int depth) { max_depth = depth; }
+  void set_russian_roulette(bool on) { russian_roulette = on; }
+  void set_min_throughput(float fraction) { min_throughput = fraction; }
   void draw_caustics_map();
 
   optix::float3 caustics_irradiance(const HitInfo& hit, float max_distance, int no_of_particles);
@@ -33,6 +42,13 @@ protected:
   optix::float3 get_transmittance(const HitInfo& hit) const;
 
   PhotonMap<> caustics;
+  unsigned int max_depth;
+  bool russian_roulette;
+  float min_throughput;
+
+  // Statistics
+  unsigned long particles_traced;
+  unsigned long particle_bounces;
 };
 
 #endif // PARTICLE_TRACER
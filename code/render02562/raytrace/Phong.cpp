@@ -4,6 +4,7 @@
 
 #include <optix_world.h>
 #include "HitInfo.h"
+#include "mt_random.h"
 #include "Phong.h"
 #include <stdio.h>
 
@@ -36,10 +37,16 @@ float3 Phong::shade(const Ray& r, HitInfo& hit, bool emit) const
     // s                  (shininess or Phong exponent of the material)
     //
     // Hint: Call the sample function associated with each light in the scene.
+
+    // The multiple importance sampling estimator in Lambertian uses the Phong BRDF below
+    if(heuristic != mis_none)
+        return Lambertian::shade(r, hit, emit);
+
     float3 wi, wo, wr, Li;
     float3 Lr = make_float3(0.0);
-    for (int i = 0; i < lights.size(); i++) {
-        Light *light = lights[i];
+    for (unsigned int i = 0; i < no_of_light_picks(); i++) {
+        float weight;
+        const Light *light = pick_light(i, weight);
         if (light->sample(hit.position, wi, Li)) {
             // Not in shadows, we add this light participation
             wr = normalize(reflect(-wi, hit.shading_normal));
@@ -53,10 +60,54 @@ float3 Phong::shade(const Ray& r, HitInfo& hit, bool emit) const
             dotproduct = fmax(dotproduct, 0);
             float3 second_coeff = rho_s*(s + 2)*pow(dotproduct, s)*M_1_PIf/2;
 
-            Li *= (first_coeff + second_coeff);
+            Li *= (first_coeff + second_coeff)*weight;
 //        printf("Value of Li : %f - %f - %f\n", Li.x, Li.y, Li.z);
             Lr += Li;
         }
     }
     return Lr + Lambertian::shade(r, hit, emit);
 }
+
+float3 Phong::brdf(const HitInfo& hit, const float3& wi, const float3& wo) const
+{
+    float s = get_shininess(hit);
+    float3 wr = reflect(-wi, hit.shading_normal);
+    float cos_alpha = fmaxf(dot(wo, wr), 0.0f);
+    return get_diffuse(hit)*M_1_PIf + get_specular(hit)*(s + 2.0f)*powf(cos_alpha, s)*M_1_PIf*0.5f;
+}
+
+bool Phong::sample_brdf(const HitInfo& hit, const float3& wo, float3& wi, float& pdf) const
+{
+    // Choose a lobe and sample it, the pdf is that of the mixture
+    if(mt_random() < get_specular_prob(hit))
+    {
+        float s = get_shininess(hit);
+        float cos_alpha = powf(static_cast<float>(mt_random()), 1.0f/(s + 1.0f));
+        float sin_alpha = sqrtf(fmaxf(1.0f - cos_alpha*cos_alpha, 0.0f));
+        float phi = 2.0f*M_PIf*static_cast<float>(mt_random());
+        wi = make_float3(sin_alpha*cosf(phi), sin_alpha*sinf(phi), cos_alpha);
+        Onb onb(reflect(-wo, hit.shading_normal));
+        onb.inverse_transform(wi);
+    }
+    else
+    {
+        cosine_sample_hemisphere(static_cast<float>(mt_random()), static_cast<float>(mt_random()), wi);
+        Onb onb(hit.shading_normal);
+        onb.inverse_transform(wi);
+    }
+    if(dot(wi, hit.shading_normal) <= 0.0f)
+        return false;
+    pdf = brdf_pdf(hit, wi, wo);
+    return pdf > 0.0f;
+}
+
+float Phong::brdf_pdf(const HitInfo& hit, const float3& wi, const float3& wo) const
+{
+    float p_s = get_specular_prob(hit);
+    float s = get_shininess(hit);
+    float3 wr = reflect(-wo, hit.shading_normal);
+    float cos_alpha = fmaxf(dot(wi, wr), 0.0f);
+    float diffuse_pdf = fmaxf(dot(wi, hit.shading_normal), 0.0f)*M_1_PIf;
+    float specular_pdf = (s + 1.0f)*powf(cos_alpha, s)*M_1_PIf*0.5f;
+    return (1.0f - p_s)*diffuse_pdf + p_s*specular_pdf;
+}
@@ -20,6 +20,20 @@ public:
   virtual optix::float3 shade(const optix::Ray& r, HitInfo& hit, bool emit = true) const;
 
 protected:
+  virtual optix::float3 brdf(const HitInfo& hit, const optix::float3& wi, const optix::float3& wo) const;
+  virtual bool sample_brdf(const HitInfo& hit, const optix::float3& wo, optix::float3& wi, float& pdf) const;
+  virtual float brdf_pdf(const HitInfo& hit, const optix::float3& wi, const optix::float3& wo) const;
+
+  // Probability of sampling the specular lobe rather than the diffuse one
+  float get_specular_prob(const HitInfo& hit) const
+  {
+    optix::float3 rho_d = get_diffuse(hit);
+    optix::float3 rho_s = get_specular(hit);
+    float d = rho_d.x + rho_d.y + rho_d.z;
+    float s = rho_s.x + rho_s.y + rho_s.z;
+    return d + s > 0.0f ? s/(d + s) : 0.0f;
+  }
+
   optix::float3 get_specular(const HitInfo& hit) const
   {
     const ObjMaterial* m = hit.material;
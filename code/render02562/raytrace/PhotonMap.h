@@ -105,6 +105,14 @@ public:
 
   ~PhotonMap() { std::free(photons); }
 
+  // Remove all photons so that the map can be filled again
+  void clear()
+  {
+    stored_photons = 0;
+    prev_scale = 1;
+    bbox.invalidate();
+  }
+
   int get_photon_count() const { return stored_photons; }
   int get_max_photon_count() const { return max_photons; }
 
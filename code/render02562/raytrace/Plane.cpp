@@ -5,6 +5,7 @@
 #include <optix_world.h>
 #include "HitInfo.h"
 #include "Plane.h"
+#include "ray_differentials.h"
 
 using namespace optix;
 
@@ -18,11 +19,10 @@ bool Plane::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     //
     // Output: hit.has_hit          (set true if the ray intersects the plane)
     //         hit.dist             (distance from the ray origin to the intersection point)
-    //         hit.position         (coordinates of the intersection point)
-    //         hit.geometric_normal (the normalized normal of the plane)
-    //         hit.shading_normal   (the normalized normal of the plane)
-    //         hit.material         (pointer to the material of the plane)
-    //        (hit.texcoord)        (texture coordinates of intersection point, not needed for Week 1)
+    //         hit.object           (pointer to this plane)
+    //
+    // The remaining hit info is computed in compute_hit_attributes(...)
+    // for the closest hit only.
     //
     // Return: True if the ray intersects the plane, false otherwise
     //         (do not return hit.has_hit as it is shared between all primitives and remains true once it is set true)
@@ -58,7 +58,15 @@ bool Plane::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     // Intersects with the plane, setting hit properties
     hit.has_hit = true;
     hit.dist = dist;
-    hit.position = r.origin + r.direction*dist;
+    hit.object = this;
+    hit.prim_idx = prim_idx;
+
+    return true;
+}
+
+void Plane::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    hit.position = r.origin + r.direction*hit.dist;
     hit.geometric_normal = onb.m_normal;
     hit.shading_normal = onb.m_normal;
     hit.material = &material;
@@ -66,9 +74,16 @@ bool Plane::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     // Test for texture
     if (material.has_texture) {
         get_uv(hit.position, hit.texcoord.x, hit.texcoord.y);
-    }
 
-    return true;
+        // The texture coordinates are linear in the position
+        if(hit.has_differentials)
+        {
+            float3 dpdx, dpdy;
+            transfer_ray_differentials(r, hit, onb.m_normal, dpdx, dpdy);
+            hit.texcoord_dx = make_float2(dot(dpdx, onb.m_tangent), dot(dpdx, onb.m_binormal))*tex_scale;
+            hit.texcoord_dy = make_float2(dot(dpdy, onb.m_tangent), dot(dpdy, onb.m_binormal))*tex_scale;
+        }
+    }
 }
 
 void Plane::transform(const Matrix4x4& m)
@@ -18,6 +18,7 @@ public:
 
   virtual bool sample(const optix::float3& pos, optix::float3& dir, optix::float3& L) const;
   virtual bool emit(optix::Ray& r, HitInfo& hit, optix::float3& Phi) const;
+  virtual optix::float3 get_power() const { return 4.0f*M_PIf*intensity; }
 
 protected:
   optix::float3 light_pos;
@@ -7,12 +7,18 @@
 #include "mt_random.h"
 #include "Shader.h"
 #include "HitInfo.h"
+#include "RenderStats.h"
 #include "RayCaster.h"
 
 using namespace std;
 using namespace optix;
 
 float3 RayCaster::compute_pixel(unsigned int x, unsigned int y) const
+{
+    return compute_pixel(x, y, 0);
+}
+
+float3 RayCaster::compute_pixel(unsigned int x, unsigned int y, Aovs* aovs) const
 {
     // Use the scene and its camera
     // to cast a ray that computes the color of the pixel at index (x, y).
@@ -32,9 +38,17 @@ float3 RayCaster::compute_pixel(unsigned int x, unsigned int y) const
     //        (b) Use get_background(...) if the ray does not hit anything.
 
     int n_subpixels = pow(subdivs, 2);
+    render_stats.add(RenderStats::camera_rays, n_subpixels);
     float3 result = make_float3(0.0f);
     float xip = x * win_to_ip.x + lower_left.x;
     float yip = y * win_to_ip.y + lower_left.y;
+    unsigned int hits = 0;
+    if(aovs)
+    {
+        aovs->albedo = aovs->normal = make_float3(0.0f);
+        aovs->depth = 0.0f;
+        aovs->samples = static_cast<float>(n_subpixels);
+    }
 
     for (int i = 0; i < n_subpixels; i++) {
         float2 displacement = jitter[i];
@@ -42,16 +56,37 @@ float3 RayCaster::compute_pixel(unsigned int x, unsigned int y) const
 
         Ray r = scene->get_camera()->get_ray(coords);
 
+        // The footprint of each sample is a subpixel
         HitInfo hit = HitInfo();
+        hit.has_differentials = true;
+        hit.dodx = hit.dody = make_float3(0.0f);
+        scene->get_camera()->get_ray_differentials(coords, win_to_ip/static_cast<float>(subdivs), hit.dddx, hit.dddy);
         scene->closest_hit(r, hit);
 
         if (hit.has_hit) {
-            result += get_shader(hit)->shade(r, hit);
+            const Shader* s = get_shader(hit);
+            if(aovs)
+            {
+                aovs->albedo += s->get_albedo(hit);
+                aovs->normal += hit.shading_normal;
+                aovs->depth += hit.dist;
+                ++hits;
+            }
+            result += s->shade(r, hit);
         } else {
             result += get_background();
+            if(aovs)
+                aovs->albedo += get_background();
         }
 //    return (r.direction + 1)/2;
     }
+    if(aovs)
+    {
+        aovs->albedo /= static_cast<float>(n_subpixels);
+        aovs->normal /= static_cast<float>(n_subpixels);
+        if(hits > 0)
+            aovs->depth /= static_cast<float>(hits);
+    }
     return result/n_subpixels;
 }
 
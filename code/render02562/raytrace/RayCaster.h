@@ -8,6 +8,7 @@
 #include <vector>
 #include <optix_world.h>
 #include "SphereTexture.h"
+#include "Aovs.h"
 #include "Tracer.h"
 
 class RayCaster : public Tracer
@@ -21,6 +22,9 @@ public:
   
   virtual optix::float3 compute_pixel(unsigned int x, unsigned int y) const;
 
+  // Also averages the auxiliary outputs of the first hits if aovs is non-null
+  optix::float3 compute_pixel(unsigned int x, unsigned int y, Aovs* aovs) const;
+
   void set_background(const optix::float3& color) { background = color; }
   void set_background(SphereTexture* sphere_texture) { sphere_tex = sphere_texture; }
   const optix::float3& get_background() const { return background; }
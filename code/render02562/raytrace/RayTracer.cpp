@@ -6,6 +6,7 @@
 #include "HitInfo.h"
 #include "ObjMaterial.h"
 #include "fresnel.h"
+#include "RenderStats.h"
 #include "RayTracer.h"
 #include <stdio.h>
 
@@ -34,6 +35,7 @@ bool RayTracer::trace_reflected(const Ray& in, const HitInfo& in_hit, Ray& out,
     out_hit.ray_ior = in_hit.ray_ior;
     out_hit.trace_depth = in_hit.trace_depth + 1;
 
+    render_stats.add(RenderStats::reflected_rays);
     return trace_to_closest(out, out_hit);
 }
 
@@ -68,6 +70,7 @@ bool RayTracer::trace_refracted(const Ray& in, const HitInfo& in_hit, Ray& out,
     out.tmax = RT_DEFAULT_MAX;
     out.tmin = 1.0e-4f;
 
+    render_stats.add(RenderStats::refracted_rays);
     return trace_to_closest(out, out_hit);
 }
 
@@ -110,6 +113,7 @@ bool RayTracer::trace_refracted(const Ray& in, const HitInfo& in_hit, Ray& out,
     out.tmax = RT_DEFAULT_MAX;
     out.tmin = 1.0e-4f;
 
+    render_stats.add(RenderStats::refracted_rays);
     return trace_to_closest(out, out_hit);
 }
 
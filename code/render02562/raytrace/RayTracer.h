@@ -8,6 +8,7 @@
 #include <optix_world.h>
 #include "Scene.h"
 #include "HitInfo.h"
+#include "RenderStats.h"
 #include "RayCaster.h"
 
 class RayTracer : public RayCaster
@@ -18,7 +19,11 @@ public:
   { }
 
   bool trace_to_closest(optix::Ray& r, HitInfo& hit) const { return scene->closest_hit(r, hit); }
-  bool trace_to_any(optix::Ray& r, HitInfo& hit) const { return scene->any_hit(r, hit); }
+  bool trace_to_any(optix::Ray& r, HitInfo& hit) const 
+  { 
+    render_stats.add(RenderStats::shadow_rays); 
+    return scene->any_hit(r, hit); 
+  }
   bool trace_reflected(const optix::Ray& in, const HitInfo& in_hit, optix::Ray& out, HitInfo& out_hit) const;
   bool trace_refracted(const optix::Ray& in, const HitInfo& in_hit, optix::Ray& out, HitInfo& out_hit) const;
   bool trace_refracted(const optix::Ray& in, const HitInfo& in_hit, optix::Ray& out, HitInfo& out_hit, float& fresnel_R) const;
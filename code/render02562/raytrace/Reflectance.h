@@ -18,6 +18,8 @@ public:
     return get_diffuse(hit) + Emission::shade(r, hit, emit); 
   }
 
+  virtual optix::float3 get_albedo(const HitInfo& hit) const { return get_diffuse(hit); }
+
 protected:
   virtual optix::float3 get_diffuse(const HitInfo& hit) const
   {
@@ -0,0 +1,68 @@
+// 02566 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2009
+// Copyright (c) DTU Informatics 2009
+
+#include "Reinhard.h"
+
+using namespace std;
+
+void Reinhard::apply(float* data, unsigned int w, unsigned int h, unsigned int channels) const
+{
+  int size = w*h;
+  #pragma omp parallel for
+  for(int i = 0; i < size; ++i)
+  {
+    float* pixel = data + i*channels;
+    float scale = get_scale(pixel, channels);
+    for(unsigned int k = 0; k < channels; ++k)
+      pixel[k] *= scale;
+  }
+  gamma_map.apply(data, w, h, channels);
+}
+
+void Reinhard::unapply(float* data, unsigned int w, unsigned int h, unsigned int channels) const
+{
+  gamma_map.unapply(data, w, h, channels);
+  int size = w*h;
+  #pragma omp parallel for
+  for(int i = 0; i < size; ++i)
+  {
+    // Invert L' = L/(1 + L) and divide by the scale used in apply(...)
+    float* pixel = data + i*channels;
+    float L_mapped = get_luminance(pixel, channels);
+    float L = L_mapped < 1.0f ? L_mapped/(1.0f - L_mapped) : 1.0e6f;
+    float scale = exposure/(1.0f + L);
+    for(unsigned int k = 0; k < channels; ++k)
+      pixel[k] /= scale;
+  }
+}
+
+void Reinhard::apply_to_bytes(const float* data, unsigned char* out, unsigned int w, unsigned int h, unsigned int channels) const
+{
+  unsigned int row_size = w*channels;
+  #pragma omp parallel for
+  for(int j = 0; j < static_cast<int>(h); ++j)
+  {
+    const float* in_row = data + (h - j - 1)*row_size;
+    unsigned char* out_row = out + j*row_size;
+    for(unsigned int i = 0; i < row_size; i += channels)
+    {
+      float scale = get_scale(in_row + i, channels);
+      for(unsigned int k = 0; k < channels; ++k)
+        out_row[i + k] = gamma_map.to_byte(in_row[i + k]*scale);
+    }
+  }
+}
+
+float Reinhard::get_luminance(const float* pixel, unsigned int channels) const
+{
+  if(channels < 3)
+    return pixel[0];
+  return 0.3f*pixel[0] + 0.59f*pixel[1] + 0.11f*pixel[2];
+}
+
+float Reinhard::get_scale(const float* pixel, unsigned int channels) const
+{
+  float L = exposure*get_luminance(pixel, channels);
+  return L > 0.0f ? exposure/(1.0f + L) : exposure;
+}
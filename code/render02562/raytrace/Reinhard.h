@@ -0,0 +1,32 @@
+// 02566 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2009
+// Copyright (c) DTU Informatics 2009
+
+#ifndef REINHARD_H
+#define REINHARD_H
+
+#include "ToneMap.h"
+#include "Gamma.h"
+
+// The global operator of Reinhard et al. [2002], which maps the luminance L
+// (after exposure) to L/(1 + L), followed by gamma correction
+class Reinhard : public ToneMap
+{
+public:
+  Reinhard(double gamma, float exposure_scale = 1.0f) : gamma_map(gamma), exposure(exposure_scale) { }
+
+  virtual void apply(float* data, unsigned int width, unsigned int height, unsigned int channels) const;
+  virtual void unapply(float* data, unsigned int width, unsigned int height, unsigned int channels) const;
+  virtual void apply_to_bytes(const float* data, unsigned char* out, unsigned int width, unsigned int height, unsigned int channels) const;
+
+  void set_exposure(float exposure_scale) { exposure = exposure_scale; }
+
+protected:
+  float get_luminance(const float* pixel, unsigned int channels) const;
+  float get_scale(const float* pixel, unsigned int channels) const;
+
+  Gamma gamma_map;
+  float exposure;
+};
+
+#endif // REINHARD_H
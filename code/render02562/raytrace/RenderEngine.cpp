@@ -3,6 +3,7 @@
 // Copyright (c) DTU Informatics 2011
 
 #include <iostream>
+#include <cstdio>
 #include <algorithm>
 #include <list>
 #include <string>
@@ -13,7 +14,10 @@
 #include "Timer.h"
 #include "mt_random.h"
 #include "Directional.h"
+#include "EnvironmentLight.h"
 #include "PointLight.h"
+#include "hdr_io.h"
+#include "RenderStats.h"
 #include "RenderEngine.h"
 
 #ifdef _OPENMP
@@ -43,21 +47,38 @@ namespace
 RenderEngine::RenderEngine()
         : win(optix::make_uint2(512, 512)),                        // Default window size
           res(optix::make_uint2(512, 512)),                        // Default render resolution
+          has_window(false),                                       // Set when the GLUT window is created
           image(res.x*res.y),
           image_tex(0),
+          tone_mapped(false),
+          sequence_frames(0),                                      // Frames rendered along a camera path (0: one per keyframe)
           scene(&cam),
+          compact_meshes(false),                                   // Ray trace meshes using compact storage
+          two_level_acc(false),                                    // Separate trees per mesh under a refittable top level (for animation)
+          out_of_core_budget(0),                                   // Resident MB of all meshes kept in mapped files (0: load into memory)
+          tiled_textures(true),                                    // Store texels in 8x8 tiles for cache-friendly look-ups
+          byte_texels(false),                                      // Store LDR textures with 8 bits per channel (4x less memory)
+          texture_budget(0),                                       // MB of textures kept between frames, loaded on demand (0: load all up front)
           filename("out.ppm"),                                     // Default output file name
+          exr_output(false),                                       // Also store the linear render result as OpenEXR
+          pfm_output(false),                                       // Also store the linear render result as PFM
+          aov_output(false),                                       // Add albedo, normal, depth, and sample count to the HDR output
+          stats_output(false),                                     // Count rays, traversal steps, and photon lookups per phase (JSON)
           tracer(res.x, res.y, &scene, 100000),                    // Maximum number of photons in map
           max_to_trace(500000),                                    // Maximum number of photons to trace
           caustics_particles(20000),                               // Desired number of caustics photons
+          max_particle_depth(500),                                 // Maximum number of specular bounces of a photon
           done(false),
           light_pow(optix::make_float3(M_PIf)),                    // Power of the default light
           light_dir(optix::make_float3(-1.0f)),                    // Direction of the default light
           default_light(&tracer, light_pow, light_dir),            // Construct default light
           use_default_light(true),                                 // Choose whether to use the default light or not
+          light_selector(scene.get_lights(), 4),                   // Lights picked per shading point in scenes with many lights
           shadows_on(true),
           background(optix::make_float3(0.1f, 0.3f, 0.6f)),        // Background color
           bgtex_filename(""),                                      // Background texture file name
+          environment_light(true),                                 // Light the scene by the background texture if it is HDR
+          env_light(&tracer, &bgtex, 8),                           // Number of samples per environment light evaluation
           current_shader(0),
           lambertian(scene.get_lights()),
           photon_caustics(&tracer, scene.get_lights(), 1.0f, 50),  // Max distance and number of photons to search for
@@ -66,7 +87,11 @@ RenderEngine::RenderEngine()
           transparent(&tracer),
           volume(&tracer),
           glossy_volume(&tracer, scene.get_lights(), 6),           // Max ray tracing recursion depth
-          tone_map(1.8)                                            // Gamma for gamma correction
+          gamma_map(1.8),                                          // Gamma for gamma correction
+          reinhard_map(1.8),                                       // Gamma after the Reinhard operator
+          tone_map(&gamma_map),                                    // Tone map operator (&reinhard_map for HDR scenes)
+          denoiser(5),                                             // Number of a-trous filter passes
+          denoise(false)                                           // Denoise the render result guided by albedo, normal, and depth
 {
     shaders.push_back(&reflectance);                           // number key 0 (reflectance only)
     shaders.push_back(&lambertian);                            // number key 1 (direct lighting)
@@ -75,6 +100,10 @@ RenderEngine::RenderEngine()
 
 void RenderEngine::load_files(int argc, char** argv)
 {
+    render_stats.set_enabled(stats_output);
+    Timer timer;
+    timer.start();
+    scene.set_out_of_core_budget(static_cast<size_t>(out_of_core_budget)*1024*1024);
     if(argc > 1)
     {
         for(int i = 1; i < argc; ++i)
@@ -82,14 +111,43 @@ void RenderEngine::load_files(int argc, char** argv)
             // Retrieve filename without path
             list<string> path_split;
             split(argv[i], path_split, "\\");
-            filename = path_split.back();
-            if(filename.find("/") != filename.npos)
+            string name = path_split.back();
+            if(name.find("/") != name.npos)
             {
                 path_split.clear();
-                split(filename, path_split, "/");
-                filename = path_split.back();
+                split(name, path_split, "/");
+                name = path_split.back();
+            }
+            lower_case_string(name);
+
+            // Instance files place shared copies of meshes
+            if(name.size() > 5 && name.compare(name.size() - 5, 5, ".inst") == 0)
+            {
+                scene.load_instances(argv[i]);
+                continue;
+            }
+
+            // A camera path switches to rendering a sequence of frames
+            if(name.size() > 4 && name.compare(name.size() - 4, 4, ".cam") == 0)
+            {
+                if(camera_path.load(argv[i]))
+                    cout << "Loaded camera path with " << camera_path.get_no_of_keyframes() << " keyframes" << endl;
+                continue;
             }
-            lower_case_string(filename);
+
+            // Keyframed mesh transformations need the refittable two-level accelerator
+            if(name.size() > 5 && name.compare(name.size() - 5, 5, ".anim") == 0)
+            {
+                if(mesh_animation.load(argv[i]))
+                {
+                    cout << "Loaded mesh animation with " << mesh_animation.get_no_of_keyframes() << " keyframes" << endl;
+                    two_level_acc = true;
+                }
+                continue;
+            }
+
+            // Outputs are named after the mesh file loaded last
+            filename = name;
             Matrix4x4 transform = Matrix4x4::identity();
 
             // Special rules for some meshes
@@ -104,6 +162,8 @@ void RenderEngine::load_files(int argc, char** argv)
             scene.load_mesh(argv[i], transform);
         }
         init_view();
+        if(has_camera_path())
+            camera_path.set_camera(camera_path.get_start_time(), cam);
     }
     else
     {
@@ -114,6 +174,8 @@ void RenderEngine::load_files(int argc, char** argv)
         scene.add_light(new PointLight(&tracer, make_float3(M_PIf), make_float3(0.0f, 1.0f, 0.0f)));
         cam.set(make_float3(2.0f, 1.5f, 2.0f), make_float3(0.0f, 0.5, 0.0f), make_float3(0.0f, 1.0f, 0.0f), 1.0f);
     }
+    timer.stop();
+    render_stats.end_phase("load", timer);
 }
 
 void RenderEngine::init_GLUT(int argc, char** argv)
@@ -122,6 +184,7 @@ void RenderEngine::init_GLUT(int argc, char** argv)
     glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowSize(win.x, win.y);
     glutCreateWindow("02562 Render Framework");
+    has_window = true;
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
@@ -149,12 +212,17 @@ void RenderEngine::init_tracer()
     clear_image();
 
     // Insert background texture/color
+    Timer timer;
+    timer.start();
     tracer.set_background(background);
+    bool hdr_background = false;
     if(!bgtex_filename.empty())
     {
+        bgtex.set_opengl(has_window);
         list<string> dot_split;
         split(bgtex_filename, dot_split, ".");
-        if(dot_split.back() == "hdr")
+        hdr_background = dot_split.back() == "hdr";
+        if(hdr_background)
             bgtex.load_hdr(bgtex_filename.c_str());
         else
             bgtex.load(bgtex_filename.c_str());
@@ -171,11 +239,25 @@ void RenderEngine::init_tracer()
     scene.set_shader(12, &glossy_volume);         // shader for illum 12
 
     // Load material textures
+    scene.set_texture_storage(tiled_textures, byte_texels);
+    scene.set_texture_budget(static_cast<size_t>(texture_budget)*1024*1024);
+    scene.set_opengl_textures(has_window);
     scene.load_textures();
+    timer.stop();
+    render_stats.end_phase("textures", timer);
 
     // Add polygons with an ambient material as area light sources
     unsigned int lights_in_scene = scene.extract_area_lights(&tracer, 8);  // Set number of samples per light source here
 
+    // Importance sample the HDR background as a light source
+    if(hdr_background && environment_light && bgtex.has_texture())
+    {
+        cout << "Adding environment light: " << bgtex_filename << endl;
+        env_light.build();
+        scene.add_light(&env_light);
+        ++lights_in_scene;
+    }
+
     // If no light in scene, add default light source (shadow off)
     if(lights_in_scene == 0 && use_default_light)
     {
@@ -183,20 +265,39 @@ void RenderEngine::init_tracer()
         scene.add_light(&default_light);
     }
 
+    // Pick lights by power if there are more lights than we want to visit per shading point
+    light_selector.build();
+    if(light_selector.is_active())
+    {
+        cout << "Sampling " << light_selector.get_no_of_picks() << " of " << scene.get_lights().size() << " lights per shading point" << endl;
+        lambertian.set_light_selector(&light_selector);
+        glossy.set_light_selector(&light_selector);
+        photon_caustics.set_light_selector(&light_selector);
+    }
+
     // Build acceleration data structure
-    Timer timer;
     cout << "Building acceleration structure...";
     timer.start();
+    scene.set_compact_meshes(compact_meshes);
+    scene.set_two_level_accelerator(two_level_acc);
     scene.init_accelerator();
+    if(has_mesh_animation())
+    {
+        mesh_animation.set_transforms(has_camera_path() ? camera_path.get_start_time() : mesh_animation.get_start_time(), scene);
+        scene.update_accelerator();
+    }
     timer.stop();
     cout << "(time: " << timer.get_time() << ")" << endl;
+    render_stats.end_phase("accelerator", timer);
 
     // Build photon maps
     cout << "Building photon maps... " << endl;
     timer.start();
+    tracer.set_max_particle_depth(max_particle_depth);
     tracer.build_maps(caustics_particles, max_to_trace);
     timer.stop();
     cout << "Building time: " << timer.get_time() << endl;
+    render_stats.end_phase("photons", timer);
 }
 
 void RenderEngine::init_texture()
@@ -220,7 +321,8 @@ void RenderEngine::apply_tone_map()
 {
     if(done)
     {
-        tone_map.apply(&image[0].x, res.x, res.y, 3);
+        tone_map->apply(&image[0].x, res.x, res.y, 3);
+        tone_mapped = true;
         init_texture();
         glutPostRedisplay();
     }
@@ -230,12 +332,34 @@ void RenderEngine::unapply_tone_map()
 {
     if(done)
     {
-        tone_map.unapply(&image[0].x, res.x, res.y, 3);
+        tone_map->unapply(&image[0].x, res.x, res.y, 3);
+        tone_mapped = false;
         init_texture();
         glutPostRedisplay();
     }
 }
 
+void RenderEngine::denoise_image()
+{
+    if(done && aovs.size() == image.size())
+    {
+        apply_denoiser();
+        init_texture();
+        glutPostRedisplay();
+    }
+}
+
+void RenderEngine::apply_denoiser()
+{
+    cout << "Denoising";
+    Timer timer;
+    timer.start();
+    denoiser.apply(&image[0], &aovs[0], res.x, res.y);
+    timer.stop();
+    cout << " - " << timer.get_time() << " secs " << endl;
+    render_stats.end_phase("denoise", timer);
+}
+
 void RenderEngine::add_textures()
 {
     reflectance.set_textures(scene.get_textures());
@@ -246,64 +370,246 @@ void RenderEngine::add_textures()
     scene.textures_on();
 }
 
+MisHeuristic RenderEngine::cycle_mis()
+{
+    MisHeuristic heuristic = static_cast<MisHeuristic>((lambertian.get_mis() + 1)%3);
+    lambertian.set_mis(heuristic);
+    glossy.set_mis(heuristic);
+    photon_caustics.set_mis(heuristic);
+    return heuristic;
+}
+
 void RenderEngine::render()
 {
     cout << "Raytracing";
     Timer timer;
     timer.start();
-#pragma omp parallel for private(randomizer)
-    for(int y = 0; y < static_cast<int>(res.y); ++y)
+    bool collect_aovs = aov_output || denoise;
+    aovs.resize(collect_aovs ? res.x*res.y : 0);
+
+    // Each thread times its share of the rows to reveal load imbalance
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    vector<double> thread_wall(threads, 0.0), thread_cpu(threads, 0.0);
+#pragma omp parallel private(randomizer)
     {
-        for(int x = 0; x < static_cast<int>(res.x); x++)
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        ScopedTimer thread_timer(thread_wall[thread], &thread_cpu[thread]);
+#pragma omp for
+        for(int y = 0; y < static_cast<int>(res.y); ++y)
         {
-            image.at(y*res.y+x) = tracer.compute_pixel(x, y);
-        }
-        // Insert the inner loop which runs through each pixel in a row and
-        // stores the result of calling compute_pixel in the image array.
-        //
-        // Relevant data fields that are available (see RenderEngine.h)
-        // res     (image resolution)
-        // image   (flat array of rgb color vectors with res.x*res.y elements)
-        // tracer  (ray tracer with access to the function compute_pixel)
+            for(int x = 0; x < static_cast<int>(res.x); x++)
+            {
+                image.at(y*res.x+x) = tracer.compute_pixel(x, y, collect_aovs ? &aovs[y*res.x+x] : 0);
+            }
+            // Insert the inner loop which runs through each pixel in a row and
+            // stores the result of calling compute_pixel in the image array.
+            //
+            // Relevant data fields that are available (see RenderEngine.h)
+            // res     (image resolution)
+            // image   (flat array of rgb color vectors with res.x*res.y elements)
+            // tracer  (ray tracer with access to the function compute_pixel)
 
 
-        if(((y + 1) % 50) == 0)
-            cerr << ".";
+            if(((y + 1) % 50) == 0)
+                cerr << ".";
+        }
     }
     timer.stop();
-    cout << " - " << timer.get_time() << " secs " << endl;
-
-    init_texture();
+    cout << " - " << timer.get_time() << " secs (CPU " << timer.get_cpu_time() << " secs";
+    if(threads > 1)
+        cout << ", thread CPU " << *min_element(thread_cpu.begin(), thread_cpu.end()) 
+             << "-" << *max_element(thread_cpu.begin(), thread_cpu.end()) << " secs";
+    cout << ")" << endl;
+    render_stats.end_phase("render", timer);
+    scene.trim_textures();
+
+    if(denoise)
+        apply_denoiser();
+
+    tone_mapped = false;
+    if(has_window)
+        init_texture();
     done = true;
 }
 
 
+void RenderEngine::render_sequence()
+{
+    // Frames are spread evenly over the time span of the camera path and
+    // the mesh animation, or placed at their keyframes
+    float start = has_camera_path() ? camera_path.get_start_time() : mesh_animation.get_start_time();
+    float end = has_camera_path() ? camera_path.get_end_time() : mesh_animation.get_end_time();
+    if(has_camera_path() && has_mesh_animation())
+    {
+        start = fminf(start, mesh_animation.get_start_time());
+        end = fmaxf(end, mesh_animation.get_end_time());
+    }
+    vector<float> times;
+    if(sequence_frames > 0)
+    {
+        for(unsigned int i = 0; i < sequence_frames; ++i)
+            times.push_back(start + (sequence_frames > 1 ? (end - start)*i/static_cast<float>(sequence_frames - 1) : 0.0f));
+    }
+    else
+    {
+        for(unsigned int i = 0; i < camera_path.get_no_of_keyframes(); ++i)
+            times.push_back(camera_path.get_keyframe_time(i));
+        mesh_animation.get_keyframe_times(times);
+        sort(times.begin(), times.end());
+        times.erase(unique(times.begin(), times.end()), times.end());
+    }
+    unsigned int frames = times.size();
+    cout << "Rendering " << frames << " frames" << endl;
+
+    // Only the camera and the mesh transformations change between frames.
+    // Moving meshes move the area lights extracted from them and the
+    // caustics, so lights and photon maps are then rebuilt every frame.
+    // Everything else built in init_tracer and the material textures are
+    // used for all frames.
+    add_textures();
+    Timer timer;
+    timer.start();
+    for(unsigned int i = 0; i < frames; ++i)
+    {
+        float time = times[i];
+        if(has_camera_path())
+            camera_path.set_camera(time, cam);
+        if(has_mesh_animation())
+        {
+            mesh_animation.set_transforms(time, scene);
+            scene.update_accelerator();
+            light_selector.build();
+            tracer.build_maps(caustics_particles, max_to_trace);
+        }
+        cout << "Frame " << i + 1 << "/" << frames << " (time " << time << ") ";
+        render();
+        save_as_bitmap(i, tone_map);
+        save_as_hdr(i);
+    }
+    timer.stop();
+    cout << "Sequence time: " << timer.get_time() << " secs (" << timer.get_time()/frames << " per frame)" << endl;
+    save_stats();
+}
+
+
 //////////////////////////////////////////////////////////////////////
 // Export/import
 //////////////////////////////////////////////////////////////////////
 
-void RenderEngine::save_as_bitmap()
+string RenderEngine::get_output_name(int frame) const
 {
-    string png_name = "out.png";
+    string name = "out";
     if(!filename.empty())
     {
         list<string> dot_split;
         split(filename, dot_split, ".");
-        png_name = dot_split.front() + ".png";
+        name = dot_split.front();
     }
-    unsigned char* data = new unsigned char[res.x*res.y*3];
-    for(unsigned int j = 0; j < res.y; ++j)
-        for(unsigned int i = 0; i < res.x; ++i)
+    if(frame >= 0)
+    {
+        char number[16];
+        sprintf(number, "_%04d", frame);
+        name += number;
+    }
+    return name;
+}
+
+void RenderEngine::save_as_bitmap(int frame, const ToneMap* map)
+{
+    string png_name = get_output_name(frame) + ".png";
+    Timer timer;
+    timer.start();
+
+    // Tone map (if a map is given) and convert to bytes in one pass
+    const Gamma no_correction(1.0);
+    if(!map)
+        map = &no_correction;
+    vector<unsigned char> data(res.x*res.y*3);
+    map->apply_to_bytes(&image[0].x, &data[0], res.x, res.y, 3);
+    stbi_write_png(png_name.c_str(), res.x, res.y, 3, &data[0], res.x*3);
+    timer.stop();
+    render_stats.end_phase("output", timer);
+    cout << "Rendered image stored in " << png_name << "." << endl;
+}
+
+void RenderEngine::save_as_hdr(int frame)
+{
+    if(!exr_output && !pfm_output)
+        return;
+    Timer timer;
+    timer.start();
+
+    // HDR files store linear radiance, so undo tone mapping done for display
+    vector<float3> linear;
+    const float* color = &image[0].x;
+    if(tone_mapped)
+    {
+        linear = image;
+        tone_map->unapply(&linear[0].x, res.x, res.y, 3);
+        color = &linear[0].x;
+    }
+    bool has_aovs = aov_output && aovs.size() == image.size();
+    const unsigned int aov_stride = sizeof(Aovs)/sizeof(float);
+    string name = get_output_name(frame);
+
+    if(exr_output)
+    {
+        vector<ImageChannel> channels;
+        channels.push_back(ImageChannel("R", color, 3));
+        channels.push_back(ImageChannel("G", color + 1, 3));
+        channels.push_back(ImageChannel("B", color + 2, 3));
+        if(has_aovs)
         {
-            unsigned int d_idx = (i + res.x*j)*3;
-            unsigned int i_idx = i + res.x*(res.y - j - 1);
-            data[d_idx + 0] = static_cast<unsigned int>(std::min(image[i_idx].x, 1.0f)*255.0f + 0.5f);
-            data[d_idx + 1] = static_cast<unsigned int>(std::min(image[i_idx].y, 1.0f)*255.0f + 0.5f);
-            data[d_idx + 2] = static_cast<unsigned int>(std::min(image[i_idx].z, 1.0f)*255.0f + 0.5f);
+            const Aovs& a = aovs[0];
+            channels.push_back(ImageChannel("albedo.R", &a.albedo.x, aov_stride));
+            channels.push_back(ImageChannel("albedo.G", &a.albedo.y, aov_stride));
+            channels.push_back(ImageChannel("albedo.B", &a.albedo.z, aov_stride));
+            channels.push_back(ImageChannel("N.X", &a.normal.x, aov_stride));
+            channels.push_back(ImageChannel("N.Y", &a.normal.y, aov_stride));
+            channels.push_back(ImageChannel("N.Z", &a.normal.z, aov_stride));
+            channels.push_back(ImageChannel("Z", &a.depth, aov_stride));
+            channels.push_back(ImageChannel("samples", &a.samples, aov_stride));
         }
-    stbi_write_png(png_name.c_str(), res.x, res.y, 3, data, res.x*3);
-    delete [] data;
-    cout << "Rendered image stored in " << png_name << "." << endl;
+        if(write_exr(name + ".exr", channels, res.x, res.y))
+            cout << "Linear render result stored in " << name << ".exr." << endl;
+        else
+            cerr << "Error: Could not write " << name << ".exr." << endl;
+    }
+    if(pfm_output)
+    {
+        // One file per output as PFM only holds one or three channels
+        bool ok = write_pfm(name + ".pfm", color, res.x, res.y, 3);
+        if(has_aovs)
+        {
+            ok = write_pfm(name + "_albedo.pfm", &aovs[0].albedo.x, res.x, res.y, 3, aov_stride) && ok;
+            ok = write_pfm(name + "_normal.pfm", &aovs[0].normal.x, res.x, res.y, 3, aov_stride) && ok;
+            ok = write_pfm(name + "_depth.pfm", &aovs[0].depth, res.x, res.y, 1, aov_stride) && ok;
+            ok = write_pfm(name + "_samples.pfm", &aovs[0].samples, res.x, res.y, 1, aov_stride) && ok;
+        }
+        if(ok)
+            cout << "Linear render result stored in " << name << (has_aovs ? "*.pfm." : ".pfm.") << endl;
+        else
+            cerr << "Error: Could not write " << name << ".pfm." << endl;
+    }
+    timer.stop();
+    render_stats.end_phase("output", timer);
+}
+
+void RenderEngine::save_stats()
+{
+    if(!render_stats.is_enabled())
+        return;
+    string json_name = get_output_name(-1) + "_stats.json";
+    if(render_stats.save_json(json_name))
+        cout << "Render statistics stored in " << json_name << "." << endl;
+    else
+        cerr << "Error: Could not write " << json_name << "." << endl;
 }
 
 
@@ -431,10 +737,17 @@ void RenderEngine::keyboard(unsigned char key, int x, int y)
         case '/':
             render_engine.unapply_tone_map();
             break;
+            // Press 'd' to denoise the render result (needs the auxiliary outputs
+            // collected if aov_output or denoise is switched on).
+        case 'd':
+            render_engine.denoise_image();
+            break;
             // Press 'b' to save the render result as a bitmap called out.png.
             // If obj files are loaded, the png will be named after the obj file loaded last.
+            // HDR files (out.exr, out.pfm) are stored too if they are switched on.
         case 'b':
             render_engine.save_as_bitmap();
+            render_engine.save_as_hdr();
             break;
             // Press 'r' to start a simple ray tracing (one pass -> done).
             // To switch back to preview mode after the ray tracing is done
@@ -443,7 +756,10 @@ void RenderEngine::keyboard(unsigned char key, int x, int y)
             if(render_engine.is_done())
                 render_engine.undo();
             else
+            {
                 render_engine.render();
+                render_engine.save_stats();
+            }
             glutPostRedisplay();
             break;
             // Press 's' to toggle shadows on/off
@@ -454,6 +770,18 @@ void RenderEngine::keyboard(unsigned char key, int x, int y)
             render_engine.redo_display_list();
             cout << "Toggled shadows " << (shadows_on ? "on" : "off") << endl;
             glutPostRedisplay();
+        }
+            break;
+            // Press 'm' to cycle direct lighting between light sampling only and
+            // multiple importance sampling with the balance or the power heuristic.
+        case 'm':
+        {
+            MisHeuristic heuristic = render_engine.cycle_mis();
+            render_engine.clear_image();
+            render_engine.redo_display_list();
+            const char* names[] = { "off", "balance heuristic", "power heuristic" };
+            cout << "Multiple importance sampling: " << names[heuristic] << endl;
+            glutPostRedisplay();
         }
             break;
             // Press 'x' to switch on material textures.
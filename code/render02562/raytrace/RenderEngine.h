@@ -10,8 +10,11 @@
 #include <optix_world.h>
 #include "my_glut.h"
 #include "Camera.h"
+#include "CameraPath.h"
+#include "MeshAnimation.h"
 #include "Scene.h"
 #include "Directional.h"
+#include "EnvironmentLight.h"
 #include "ParticleTracer.h"
 #include "Shader.h"
 #include "Textured.h"
@@ -24,6 +27,10 @@
 #include "GlossyVolume.h"
 #include "SphereTexture.h"
 #include "Gamma.h"
+#include "Reinhard.h"
+#include "LightSelector.h"
+#include "Aovs.h"
+#include "Denoiser.h"
 
 class RenderEngine
 {
@@ -40,6 +47,7 @@ public:
   // Rendering
   unsigned int no_of_shaders() const { return shaders.size(); }
   bool toggle_shadows() { shadows_on = !shadows_on; scene.toggle_shadows(); return shadows_on; }
+  MisHeuristic cycle_mis();
   bool is_done() const { return done; }
   void undo() { done = !done; }
   void increment_pixel_subdivs() { tracer.increment_pixel_subdivs(); }
@@ -47,11 +55,23 @@ public:
   void clear_image() { std::fill(&image[0], &image[0] + res.x*res.y, optix::make_float3(0.0f)); }
   void apply_tone_map();
   void unapply_tone_map();
+  void denoise_image();
   void add_textures();
   void render();
 
+  // Render frames along a camera path (*.cam) and/or of keyframed mesh
+  // transformations (*.anim) given on the command line. The scene, photon
+  // maps, and textures are reused. Moving meshes only refit the top level
+  // of the two-level accelerator.
+  bool has_camera_path() const { return camera_path.get_no_of_keyframes() > 0; }
+  bool has_mesh_animation() const { return mesh_animation.get_no_of_keyframes() > 0; }
+  bool has_sequence() const { return has_camera_path() || has_mesh_animation(); }
+  void render_sequence();
+
   // Export/import
-  void save_as_bitmap();
+  void save_as_bitmap(int frame = -1, const ToneMap* map = 0);
+  void save_as_hdr(int frame = -1);
+  void save_stats();
 
   // Draw functions
   void set_gl_ortho_proj();
@@ -75,27 +95,46 @@ public:
   void set_cam_const(float fd) { cam.set_cam_const(fd); }
 
 private:
-  // Window and render resolution
+  // Window and render resolution. Without a window (sequences), nothing
+  // is drawn with OpenGL.
   optix::uint2 win;
   optix::uint2 res;
+  bool has_window;
 
   // Render data
   std::vector<optix::float3> image;
+  std::vector<Aovs> aovs;
   unsigned int image_tex;
+  bool tone_mapped;
 
   // View control
   Camera cam;
+  CameraPath camera_path;
+  MeshAnimation mesh_animation;
+  unsigned int sequence_frames;
 
   // Geometry container
   Scene scene;
+  bool compact_meshes;
+  bool two_level_acc;
+  unsigned int out_of_core_budget;
+  bool tiled_textures;
+  bool byte_texels;
+  unsigned int texture_budget;
   
-  // Output file name
+  // Output file name and formats
   std::string filename;
+  bool exr_output;
+  bool pfm_output;
+  bool aov_output;
+  bool stats_output;
+  std::string get_output_name(int frame) const;
 
   // Tracer
   ParticleTracer tracer;
   unsigned int max_to_trace;
   unsigned int caustics_particles;
+  unsigned int max_particle_depth;
   bool done;
 
   // Light
@@ -103,12 +142,15 @@ private:
   optix::float3 light_dir;
   Directional default_light;
   bool use_default_light;
+  LightSelector light_selector;
   bool shadows_on;
 
   // Environment
   optix::float3 background;
   SphereTexture bgtex;
   std::string bgtex_filename;
+  bool environment_light;
+  EnvironmentLight env_light;
 
   // Shaders
   unsigned int current_shader;
@@ -123,7 +165,14 @@ private:
   GlossyVolume glossy_volume;
 
   // Tone mapping
-  Gamma tone_map;
+  Gamma gamma_map;
+  Reinhard reinhard_map;
+  ToneMap* tone_map;
+
+  // Denoising
+  Denoiser denoiser;
+  bool denoise;
+  void apply_denoiser();
 };
 
 extern RenderEngine render_engine;
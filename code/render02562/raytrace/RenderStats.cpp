@@ -0,0 +1,125 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "RenderStats.h"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace std;
+
+RenderStats render_stats;
+
+namespace
+{
+  const char* counter_names[RenderStats::no_of_counters] =
+  {
+    "camera_rays",
+    "reflected_rays",
+    "refracted_rays",
+    "shadow_rays",
+    "photon_rays",
+    "nodes_visited",
+    "primitives_tested",
+    "photon_lookups"
+  };
+
+  void write_counts(FILE* out, const unsigned long long* counts, double seconds, const char* indent)
+  {
+    typedef RenderStats RS;
+    for(unsigned int i = 0; i < RS::no_of_counters; ++i)
+      fprintf(out, "%s\"%s\": %llu,\n", indent, counter_names[i], counts[i]);
+
+    // Segments per path for camera paths and photon paths alike
+    unsigned long long paths = counts[RS::camera_rays] + counts[RS::photon_rays];
+    unsigned long long rays = paths + counts[RS::reflected_rays] + counts[RS::refracted_rays] + counts[RS::shadow_rays];
+    double depth = paths > 0 ? (paths + counts[RS::reflected_rays] + counts[RS::refracted_rays])/static_cast<double>(paths) : 0.0;
+    fprintf(out, "%s\"average_path_depth\": %g,\n", indent, depth);
+    fprintf(out, "%s\"nodes_per_ray\": %g,\n", indent, rays > 0 ? counts[RS::nodes_visited]/static_cast<double>(rays) : 0.0);
+    fprintf(out, "%s\"primitives_per_ray\": %g,\n", indent, rays > 0 ? counts[RS::primitives_tested]/static_cast<double>(rays) : 0.0);
+    fprintf(out, "%s\"rays_per_second\": %g\n", indent, seconds > 0.0 ? rays/seconds : 0.0);
+  }
+}
+
+void RenderStats::set_enabled(bool on)
+{
+  enabled = on;
+  if(enabled && slots.empty())
+  {
+#ifdef _OPENMP
+    slots.resize(omp_get_max_threads());
+#else
+    slots.resize(1);
+#endif
+    for(unsigned int i = 0; i < no_of_counters; ++i)
+      counted[i] = 0;
+  }
+}
+
+const char* RenderStats::get_counter_name(Counter c)
+{
+  return c < no_of_counters ? counter_names[c] : "";
+}
+
+void RenderStats::end_phase(const string& name, const Timer& timer)
+{
+  if(!enabled)
+    return;
+
+  Phase phase;
+  phase.name = name;
+  phase.seconds = timer.get_time();
+  phase.cpu_seconds = timer.get_cpu_time();
+  phase.runs = 1;
+  for(unsigned int i = 0; i < no_of_counters; ++i)
+  {
+    unsigned long long total = 0;
+    for(unsigned int j = 0; j < slots.size(); ++j)
+      total += slots[j].counts[i];
+    phase.counts[i] = total - counted[i];
+    counted[i] = total;
+  }
+
+  for(unsigned int i = 0; i < phases.size(); ++i)
+    if(phases[i].name == name)
+    {
+      phases[i].seconds += phase.seconds;
+      phases[i].cpu_seconds += phase.cpu_seconds;
+      ++phases[i].runs;
+      for(unsigned int j = 0; j < no_of_counters; ++j)
+        phases[i].counts[j] += phase.counts[j];
+      return;
+    }
+  phases.push_back(phase);
+}
+
+bool RenderStats::save_json(const string& filename) const
+{
+  if(!enabled)
+    return false;
+  FILE* out = fopen(filename.c_str(), "w");
+  if(!out)
+    return false;
+
+  double seconds = 0.0, cpu_seconds = 0.0;
+  fprintf(out, "{\n  \"threads\": %u,\n  \"phases\": [\n", static_cast<unsigned int>(slots.size()));
+  for(unsigned int i = 0; i < phases.size(); ++i)
+  {
+    const Phase& phase = phases[i];
+    seconds += phase.seconds;
+    cpu_seconds += phase.cpu_seconds;
+    fprintf(out, "    {\n      \"name\": \"%s\",\n      \"seconds\": %g,\n      \"cpu_seconds\": %g,\n      \"runs\": %u,\n", 
+            phase.name.c_str(), phase.seconds, phase.cpu_seconds, phase.runs);
+    write_counts(out, phase.counts, phase.seconds, "      ");
+    fprintf(out, "    }%s\n", i + 1 < phases.size() ? "," : "");
+  }
+  fprintf(out, "  ],\n  \"total\": {\n    \"seconds\": %g,\n    \"cpu_seconds\": %g,\n", seconds, cpu_seconds);
+  write_counts(out, counted, seconds, "    ");
+  fprintf(out, "  }\n}\n");
+  return fclose(out) == 0;
+}
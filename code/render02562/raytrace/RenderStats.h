@@ -0,0 +1,90 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <string>
+#include <vector>
+#include "Timer.h"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+/// Opt-in counters for the hot paths and timings of the render phases.
+/// Every thread counts in its own slot, so counting needs no locks or 
+/// atomics. Slots are summed whenever a phase ends.
+class RenderStats
+{
+public:
+  enum Counter
+  {
+    camera_rays,
+    reflected_rays,
+    refracted_rays,
+    shadow_rays,
+    photon_rays,
+    nodes_visited,
+    primitives_tested,
+    photon_lookups,
+    no_of_counters
+  };
+
+  RenderStats() : enabled(false) { }
+
+  void set_enabled(bool on);
+  bool is_enabled() const { return enabled; }
+
+  void add(Counter c, unsigned long long n = 1)
+  {
+    if(enabled)
+      slots[thread_slot()].counts[c] += n;
+  }
+
+  /// Store the wall clock and CPU time of a phase along with the counts since 
+  /// the previous phase ended. Phases with the same name (e.g. render) are 
+  /// accumulated.
+  void end_phase(const std::string& name, const Timer& timer);
+
+  /// Write phases, counters, and derived averages as JSON
+  bool save_json(const std::string& filename) const;
+
+  static const char* get_counter_name(Counter c);
+
+private:
+  // Two cache lines per slot keep the counts of two threads off the same line
+  struct Slot
+  {
+    Slot() { for(unsigned int i = 0; i < 2*no_of_counters; ++i) counts[i] = 0; }
+    unsigned long long counts[2*no_of_counters];
+  };
+
+  struct Phase
+  {
+    std::string name;
+    double seconds;
+    double cpu_seconds;
+    unsigned int runs;
+    unsigned long long counts[no_of_counters];
+  };
+
+  unsigned int thread_slot() const
+  {
+#ifdef _OPENMP
+    return static_cast<unsigned int>(omp_get_thread_num())%slots.size();
+#else
+    return 0;
+#endif
+  }
+
+  bool enabled;
+  std::vector<Slot> slots;
+  std::vector<Phase> phases;
+  unsigned long long counted[no_of_counters];  // Totals when the last phase ended
+};
+
+extern RenderStats render_stats;
+
+#endif // RENDERSTATS_H
@@ -3,6 +3,9 @@
 // Copyright (c) DTU Informatics 2011
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <optix_world.h>
 #include "mt_random.h"
 #include "my_glut.h"
@@ -10,6 +13,8 @@
 #include "TriMesh.h"
 #include "IndexedFaceSet.h"
 #include "obj_load.h"
+#include "mesh_cache.h"
+#include "fnv_hash.h"
 #include "Plane.h"
 #include "Sphere.h"
 #include "Triangle.h"
@@ -28,6 +33,21 @@
 using namespace std;
 using namespace optix;
 
+namespace
+{
+  // Tree caches are named after the mesh files only, so a tree rebuilt
+  // after changes to the geometry or the transforms replaces the old file
+  string tree_cache_file(const string& dir, const string& prefix, const vector<string>& files)
+  {
+    unsigned long long id = fnv_hash(prefix.c_str(), prefix.size());
+    for(unsigned int i = 0; i < files.size(); ++i)
+      id = fnv_hash(files[i].c_str(), files[i].size() + 1, id);
+    ostringstream name;
+    name << dir << prefix << hex << id << ".cache";
+    return name.str();
+  }
+}
+
 Scene::~Scene()
 {
   for(unsigned int i = 0; i < objects.size(); ++i)
@@ -36,27 +56,87 @@ Scene::~Scene()
     delete planes[i];
   for(unsigned int i = 0; i < light_meshes.size(); ++i)
     delete light_meshes[i];
+  for(unsigned int i = 0; i < instanced_accs.size(); ++i)
+    delete instanced_accs[i];
+  for(unsigned int i = 0; i < mesh_instances.size(); ++i)
+    delete mesh_instances[i];
+  for(unsigned int i = 0; i < mesh_accs.size(); ++i)
+    delete mesh_accs[i];
+  for(unsigned int i = 0; i < instanced_meshes.size(); ++i)
+    delete instanced_meshes[i];
   for(unsigned int i = 0; i < extracted_lights.size(); ++i)
     delete lights[extracted_lights[i]];
-  for(map<string, Texture*>::iterator i = textures.begin(); i != textures.end(); ++i)
-    delete i->second;
+  for(unsigned int i = 0; i < textures.size(); ++i)
+    delete textures[i];
+}
+
+TriMesh* Scene::read_mesh(const string& filename, const Matrix4x4& transform)
+{
+  TriMesh* mesh = new TriMesh; 
+  string cache_file = filename + ".cache";
+  if(mesh_cache_load(cache_file, transform, *mesh))
+    cout << "Loaded cached mesh " << cache_file << endl;
+  else
+  {
+    vector<string> sources(1, filename);
+    obj_load(filename, *mesh, &sources);
+    if(!mesh->has_normals())
+    {
+      cout << "Computing normals" << endl;
+      mesh->compute_normals();
+    }
+    mesh->transform(transform);
+    mesh->compute_areas();
+    mesh_cache_save(cache_file, transform, sources, *mesh);
+  }
+  return mesh;
+}
+
+bool Scene::load_out_of_core_mesh(const string& filename, const Matrix4x4& transform)
+{
+  // The mesh is converted once and then mapped from the file
+  string ooc_file = filename + ".ooc";
+  OutOfCoreMesh* mesh = new OutOfCoreMesh(ooc_file, filename, transform, &out_of_core_cache);
+  if(!mesh->is_open())
+  {
+    delete mesh;
+    cout << "Writing out-of-core mesh " << ooc_file << endl;
+    if(!OutOfCoreMesh::convert(ooc_file, filename, transform))
+      return false;
+    mesh = new OutOfCoreMesh(ooc_file, filename, transform, &out_of_core_cache);
+    if(!mesh->is_open())
+    {
+      delete mesh;
+      return false;
+    }
+  }
+  cout << "No. of triangles: " << mesh->get_no_of_faces() << " (out-of-core in " << mesh->get_no_of_primitives() << " clusters, "
+       << mesh->get_no_of_primitives()*(sizeof(Aabb) + sizeof(AccObj))/1024 << " KB of cluster bounds and accelerator entries in memory)" << endl;
+  add_material_textures(mesh->get_materials());
+  out_of_core_meshes.push_back(mesh);
+  mesh_files.push_back(filename);
+  objects.push_back(mesh);
+  transforms.push_back(Matrix4x4::identity());
+  bbox.include(mesh->compute_bbox());
+  return true;
 }
 
 void Scene::load_mesh(const string& filename, const Matrix4x4& transform)
 {
   cout << "Loading " << filename << endl;
 
-  TriMesh* mesh = new TriMesh; 
-  obj_load(filename, *mesh);
-  if(!mesh->has_normals())
+  if(out_of_core_cache.get_budget() > 0)
   {
-    cout << "Computing normals" << endl;
-    mesh->compute_normals();
+    if(load_out_of_core_mesh(filename, transform))
+      return;
+    cerr << "Could not use out-of-core mesh, loading " << filename << " into memory" << endl;
   }
-  mesh->transform(transform);
-  mesh->compute_areas();
+
+  TriMesh* mesh = read_mesh(filename, transform);
   cout << "No. of triangles: " << mesh->geometry.no_faces() << endl;
+  add_material_textures(mesh->materials);
   meshes.push_back(mesh);
+  mesh_files.push_back(filename);
   objects.push_back(mesh);
   transforms.push_back(Matrix4x4::identity());
 
@@ -65,28 +145,103 @@ void Scene::load_mesh(const string& filename, const Matrix4x4& transform)
   bbox.include(mesh_bbox);
 }
 
-void Scene::load_texture(const ObjMaterial& mat, bool is_sphere)
+void Scene::add_instance(const string& filename, const Matrix4x4& transform)
+{
+  // Load the mesh in object space the first time it is instanced
+  map<string, unsigned int>::iterator id = instanced_mesh_ids.find(filename);
+  if(id == instanced_mesh_ids.end())
+  {
+    cout << "Loading " << filename << " for instancing" << endl;
+    TriMesh* mesh = read_mesh(filename, Matrix4x4::identity());
+    cout << "No. of triangles: " << mesh->geometry.no_faces() << endl;
+    add_material_textures(mesh->materials);
+    id = instanced_mesh_ids.insert(make_pair(filename, static_cast<unsigned int>(instanced_meshes.size()))).first;
+    instanced_meshes.push_back(mesh);
+    instanced_accs.push_back(new BspTree);
+    if(mesh_files.empty())
+      mesh_files.push_back(filename);
+  }
+
+  Instance* instance = new Instance(instanced_meshes[id->second], instanced_accs[id->second], transform);
+  instances.push_back(instance);
+  instance_mesh_ids.push_back(id->second);
+  objects.push_back(instance);
+  bbox.include(instance->compute_bbox());
+}
+
+void Scene::load_instances(const string& filename)
+{
+  ifstream file(filename.c_str());
+  if(!file)
+  {
+    cerr << "Could not open " << filename << endl;
+    return;
+  }
+  size_t slash = filename.find_last_of("/\\");
+  string path = slash == string::npos ? "" : filename.substr(0, slash + 1);
+
+  unsigned int no_of_instances = instances.size();
+  string line;
+  for(unsigned int line_no = 1; getline(file, line); ++line_no)
+  {
+    istringstream in(line);
+    string mesh_file;
+    if(!(in >> mesh_file) || mesh_file[0] == '#')
+      continue;
+
+    Matrix4x4 transform = Matrix4x4::identity();
+    float* m = transform.getData();
+    unsigned int i = 0;
+    while(i < 12 && in >> m[i])
+      ++i;
+    if(i != 0 && i != 12)
+    {
+      cerr << filename << "(" << line_no << "): Expected 12 matrix entries after " << mesh_file << endl;
+      continue;
+    }
+    add_instance(path + mesh_file, transform);
+  }
+  cout << "No. of instances: " << instances.size() - no_of_instances << " of " << instanced_meshes.size() << " meshes" << endl;
+}
+
+int Scene::add_texture(const ObjMaterial& mat, bool is_sphere)
 {
-  if(mat.has_texture && textures.find(mat.tex_name) == textures.end())
+  if(!mat.has_texture)
+    return -1;
+
+  // Textures are shared by name. Shaders look them up by the index stored
+  // in the material.
+  map<string, int>::iterator id = texture_ids.find(mat.tex_name);
+  if(id == texture_ids.end())
   {
-    Texture*& tex = textures[mat.tex_name];
-    tex = is_sphere ? new InvSphereMap : new Texture;
-    string path_and_name = mat.tex_path + mat.tex_name;
-    tex->load(path_and_name.c_str());
+    id = texture_ids.insert(make_pair(mat.tex_name, static_cast<int>(texture_files.size()))).first;
+    texture_files.push_back(make_pair(mat.tex_path + mat.tex_name, is_sphere));
   }
+  return id->second;
+}
+
+void Scene::add_material_textures(vector<ObjMaterial>& materials)
+{
+  for(unsigned int i = 0; i < materials.size(); ++i)
+    materials[i].tex_id = add_texture(materials[i]);
 }
 
 void Scene::load_textures()
 {
-  for(unsigned int i = 0; i < meshes.size(); ++i)
-    for(unsigned int j = 0; j < meshes[i]->materials.size(); ++j)
-      load_texture(meshes[i]->materials[j]);
-  for(unsigned int i = 0; i < planes.size(); ++i)
-    load_texture(planes[i]->get_material());
-  for(unsigned int i = 0; i < spheres.size(); ++i)
-    load_texture(spheres[i]->get_material(), true);
-  for(unsigned int i = 0; i < triangles.size(); ++i)
-    load_texture(triangles[i]->get_material());
+  // Textures are loaded with the storage settings in effect now
+  for(unsigned int i = textures.size(); i < texture_files.size(); ++i)
+  {
+    Texture* tex = texture_files[i].second ? new InvSphereMap : new Texture;
+    tex->set_tiled(tiled_textures);
+    tex->set_byte_texels(byte_texels);
+    tex->set_opengl(opengl_textures);
+    const string& path_and_name = texture_files[i].first;
+    if(texture_cache.get_budget() > 0)
+      tex->load_on_demand(path_and_name, &texture_cache);
+    else
+      tex->load(path_and_name.c_str());
+    textures.push_back(tex);
+  }
 }
 
 void Scene::add_plane(const float3& position, const float3& normal, const string& mtl_file, unsigned int idx, float tex_scale)
@@ -96,7 +251,9 @@ void Scene::add_plane(const float3& position, const float3& normal, const string
     mtl_load(mtl_file, m);
   if(m.size() == 0)
 	  m.push_back(ObjMaterial());
-  Plane* plane = new Plane(position, normal, idx < m.size() ? m[idx] : m.back(), tex_scale);
+  ObjMaterial& mat = idx < m.size() ? m[idx] : m.back();
+  mat.tex_id = add_texture(mat);
+  Plane* plane = new Plane(position, normal, mat, tex_scale);
   planes.push_back(plane);
 }
 
@@ -107,7 +264,9 @@ void Scene::add_sphere(const float3& center, float radius, const string& mtl_fil
     mtl_load(mtl_file, m);
   if(m.size() == 0)
 	  m.push_back(ObjMaterial());
-  Sphere* sphere = new Sphere(center, radius, idx < m.size() ? m[idx] : m.back());
+  ObjMaterial& mat = idx < m.size() ? m[idx] : m.back();
+  mat.tex_id = add_texture(mat, true);
+  Sphere* sphere = new Sphere(center, radius, mat);
   spheres.push_back(sphere);
   objects.push_back(sphere);
   bbox.include(sphere->compute_bbox());
@@ -120,7 +279,9 @@ void Scene::add_triangle(const float3& v0, const float3& v1, const float3& v2, c
     mtl_load(mtl_file, m);
   if(m.size() == 0)
 	  m.push_back(ObjMaterial());
-  Triangle* triangle = new Triangle(v0, v1, v2, idx < m.size() ? m[idx] : m.back());
+  ObjMaterial& mat = idx < m.size() ? m[idx] : m.back();
+  mat.tex_id = add_texture(mat);
+  Triangle* triangle = new Triangle(v0, v1, v2, mat);
   triangles.push_back(triangle);
   objects.push_back(triangle);
   bbox.include(triangle->compute_bbox());
@@ -181,19 +342,71 @@ unsigned int Scene::extract_area_lights(RayTracer *tracer, unsigned int samples_
         }
       }
     }
-    if(mesh->geometry.no_faces() == 0)
-      delete mesh;
-    else
-    {
-      mesh->compute_areas();
-      light_meshes.push_back(mesh);
-      extracted_lights.push_back(lights.size());
-      lights.push_back(new AreaLight(tracer, mesh, samples_per_light));
-    }
+    add_area_light(mesh, get_mesh_idx(meshes[i]), tracer, samples_per_light);
+  }
+  for(unsigned int i = 0; i < out_of_core_meshes.size(); ++i)
+  {
+    TriMesh* mesh = new TriMesh;
+    out_of_core_meshes[i]->extract_emissive(*mesh);
+    add_area_light(mesh, get_mesh_idx(out_of_core_meshes[i]), tracer, samples_per_light);
   }
   return lights.size();
 }
 
+void Scene::add_area_light(TriMesh* mesh, unsigned int mesh_idx, RayTracer* tracer, unsigned int samples_per_light)
+{
+  if(mesh->geometry.no_faces() == 0)
+    delete mesh;
+  else
+  {
+    mesh->compute_areas();
+    light_meshes.push_back(mesh);
+    extracted_lights.push_back(lights.size());
+    lights.push_back(new AreaLight(tracer, mesh, samples_per_light));
+
+    // Keep the geometry at load time to apply mesh transformations to
+    const IndexedFaceSet& geometry = mesh->geometry;
+    const IndexedFaceSet& normals = mesh->normals;
+    light_mesh_ids.push_back(mesh_idx);
+    light_rest_vertices.push_back(vector<float3>(geometry.vertex_data(), geometry.vertex_data() + geometry.no_vertices()));
+    light_rest_normals.push_back(vector<float3>(normals.vertex_data(), normals.vertex_data() + normals.no_vertices()));
+  }
+}
+
+void Scene::update_area_lights()
+{
+  for(unsigned int i = 0; i < light_meshes.size(); ++i)
+  {
+    unsigned int mesh_idx = light_mesh_ids[i];
+    if(mesh_idx >= mesh_instances.size())
+      continue;
+
+    // Place the light where the mesh it was extracted from is
+    TriMesh* mesh = light_meshes[i];
+    const vector<float3>& vertices = light_rest_vertices[i];
+    const vector<float3>& normals = light_rest_normals[i];
+    mesh->geometry.assign_vertices(&vertices[0], vertices.size());
+    if(!normals.empty())
+      mesh->normals.assign_vertices(&normals[0], normals.size());
+    mesh->transform(mesh_instances[mesh_idx]->get_transform());
+    mesh->compute_areas();
+    static_cast<AreaLight*>(lights[extracted_lights[i]])->refit();
+  }
+}
+
+unsigned int Scene::get_mesh_idx(const Object3D* mesh) const
+{
+  // Meshes are numbered in the order of the scene objects (as in init_two_level_accelerator)
+  vector<const Object3D*> mesh_objects(meshes.begin(), meshes.end());
+  mesh_objects.insert(mesh_objects.end(), compact_meshes.begin(), compact_meshes.end());
+  mesh_objects.insert(mesh_objects.end(), out_of_core_meshes.begin(), out_of_core_meshes.end());
+  unsigned int mesh_idx = 0;
+  for(unsigned int i = 0; i < objects.size() && objects[i] != mesh; ++i)
+    if(find(mesh_objects.begin(), mesh_objects.end(), objects[i]) != mesh_objects.end())
+      ++mesh_idx;
+  return mesh_idx;
+}
+
 void Scene::toggle_shadows()
 {
   for(unsigned int i = 0; i < lights.size(); ++i)
@@ -234,11 +447,28 @@ void Scene::draw()
     cout << "Generating scene display list";
     if(glIsList(disp_list))
       glDeleteLists(disp_list, 1);
+
+    // Instances call one display list per instanced mesh
+    for(unsigned int i = 0; i < instanced_lists.size(); ++i)
+      glDeleteLists(instanced_lists[i], 1);
+    instanced_lists.resize(instanced_meshes.size());
+    for(unsigned int i = 0; i < instanced_meshes.size(); ++i)
+    {
+      instanced_lists[i] = glGenLists(1);
+      glNewList(instanced_lists[i], GL_COMPILE);
+      draw_mesh(instanced_meshes[i]);
+      glEndList();
+    }
     disp_list = glGenLists(1);
     glNewList(disp_list, GL_COMPILE);
 
     for(unsigned int i = 0; i < meshes.size(); ++i)
       draw_mesh(meshes[i]);
+    for(unsigned int i = 0; i < compact_meshes.size(); ++i)
+      draw_compact_mesh(compact_meshes[i]);
+    for(unsigned int i = 0; i < instances.size(); ++i)
+      draw_instance(instances[i], instanced_lists[instance_mesh_ids[i]]);
+    // Out-of-core meshes are only ray traced
     for(unsigned int i = 0; i < planes.size(); ++i)
       draw_plane(planes[i]);
     for(unsigned int i = 0; i < spheres.size(); ++i)
@@ -255,7 +485,121 @@ void Scene::draw()
 
 void Scene::init_accelerator()
 {
-  acc.init(objects, planes);
+  // Keep built trees next to the first loaded mesh
+  string cache_dir;
+  if(!mesh_files.empty())
+  {
+    const string& filename = mesh_files[0];
+    size_t slash = filename.find_last_of("/\\");
+    cache_dir = slash == string::npos ? "./" : filename.substr(0, slash + 1);
+    acc.set_cache_file(tree_cache_file(cache_dir, "bsp_", mesh_files));
+  }
+
+  // Swap the meshes for compact versions
+  if(compact)
+  {
+    for(unsigned int i = 0; i < meshes.size(); ++i)
+    {
+      const TriMesh* mesh = meshes[i];
+      CompactTriMesh* compact_mesh = new CompactTriMesh(*mesh);
+      size_t mesh_size = (mesh->geometry.no_vertices() + mesh->normals.no_vertices() + mesh->texcoords.no_vertices())*sizeof(float3)
+        + (mesh->geometry.no_faces() + mesh->normals.no_faces() + mesh->texcoords.no_faces())*sizeof(uint3)
+        + mesh->mat_idx.size()*sizeof(int);
+      cout << "Compact mesh: " << compact_mesh->get_memory_footprint()/1024 << " KB (was " << mesh_size/1024 << " KB)" << endl;
+      replace(objects.begin(), objects.end(), static_cast<Object3D*>(const_cast<TriMesh*>(mesh)), static_cast<Object3D*>(compact_mesh));
+      compact_meshes.push_back(compact_mesh);
+      delete mesh;
+    }
+    meshes.clear();
+  }
+
+  // Build one tree per instanced mesh in object space
+  for(map<string, unsigned int>::const_iterator id = instanced_mesh_ids.begin(); id != instanced_mesh_ids.end(); ++id)
+    if(!cache_dir.empty())
+      instanced_accs[id->second]->set_cache_file(tree_cache_file(cache_dir, "bsp_inst_", vector<string>(1, id->first)));
+  for(unsigned int i = 0; i < instanced_accs.size(); ++i)
+  {
+    instanced_accs[i]->init(vector<Object3D*>(1, const_cast<TriMesh*>(instanced_meshes[i])), vector<const Plane*>());
+  }
+  if(two_level)
+    init_two_level_accelerator();
+  else
+    acc.init(objects, planes);
+}
+
+void Scene::init_two_level_accelerator()
+{
+  for(unsigned int i = 0; i < mesh_instances.size(); ++i)
+    delete mesh_instances[i];
+  for(unsigned int i = 0; i < mesh_accs.size(); ++i)
+    delete mesh_accs[i];
+  mesh_instances.clear();
+  mesh_accs.clear();
+  top_level_objects.clear();
+
+  // Meshes are placed in the top level through an instance with their own tree
+  vector<const Object3D*> mesh_objects(meshes.begin(), meshes.end());
+  mesh_objects.insert(mesh_objects.end(), compact_meshes.begin(), compact_meshes.end());
+  mesh_objects.insert(mesh_objects.end(), out_of_core_meshes.begin(), out_of_core_meshes.end());
+  for(unsigned int i = 0; i < objects.size(); ++i)
+  {
+    Object3D* obj = objects[i];
+    if(find(mesh_objects.begin(), mesh_objects.end(), obj) == mesh_objects.end())
+    {
+      top_level_objects.push_back(obj);
+      continue;
+    }
+    Bvh* mesh_acc = new Bvh;
+    mesh_acc->init(vector<Object3D*>(1, obj), vector<const Plane*>());
+    Instance* instance = new Instance(obj, mesh_acc, Matrix4x4::identity());
+    mesh_accs.push_back(mesh_acc);
+    mesh_instances.push_back(instance);
+    top_level_objects.push_back(instance);
+  }
+  top_level_acc.init(top_level_objects, planes);
+  active_acc = &top_level_acc;
+}
+
+void Scene::set_mesh_transform(unsigned int mesh_idx, const Matrix4x4& transform)
+{
+  if(mesh_idx >= mesh_instances.size())
+  {
+    cerr << "Mesh " << mesh_idx << " cannot be moved (requires the two-level accelerator)" << endl;
+    return;
+  }
+  mesh_instances[mesh_idx]->set_transform(transform);
+}
+
+void Scene::set_mesh_vertices(unsigned int mesh_idx, const vector<float3>& vertices)
+{
+  const Object3D* obj = mesh_idx < mesh_instances.size() ? mesh_instances[mesh_idx]->get_object() : 0;
+  vector<const TriMesh*>::iterator m = find(meshes.begin(), meshes.end(), obj);
+  if(m == meshes.end() || (*m)->geometry.no_vertices() != vertices.size())
+  {
+    cerr << "Mesh " << mesh_idx << " cannot be deformed (requires an in-memory mesh, the same number of vertices, and the two-level accelerator)" << endl;
+    return;
+  }
+
+  // Normals are recomputed from the deformed geometry
+  TriMesh* mesh = const_cast<TriMesh*>(*m);
+  mesh->geometry.assign_vertices(&vertices[0], vertices.size());
+  mesh->compute_normals();
+  mesh->compute_areas();
+  mesh_accs[mesh_idx]->refit();
+  mesh_instances[mesh_idx]->refit();
+  redraw = true;
+}
+
+void Scene::update_accelerator()
+{
+  // Only the top level is refitted. The mesh trees are in object space.
+  if(!two_level)
+    return;
+  update_area_lights();
+  top_level_acc.refit();
+  bbox.invalidate();
+  for(unsigned int i = 0; i < top_level_objects.size(); ++i)
+    bbox.include(top_level_objects[i]->compute_bbox());
 }
 
 bool Scene::is_specular(const ObjMaterial* m) const
@@ -332,6 +676,65 @@ void Scene::draw_mesh(const TriMesh* mesh) const
     delete shades[i];
 }
 
+void Scene::draw_compact_mesh(const CompactTriMesh* mesh) const
+{
+  // Vertices are decoded one triangle at a time, so the only extra memory
+  // is a cache of shaded vertex colors (8 bits per channel, alpha marks done).
+  vector<uchar4> shades(mesh->get_no_of_vertices(), make_uchar4(0, 0, 0, 0));
+  const unsigned int faces = mesh->get_no_of_primitives();
+  const vector<ObjMaterial>& materials = mesh->get_materials();
+  glBegin(GL_TRIANGLES);
+  for(unsigned int i = 0; i < faces; ++i)
+  {
+    const unsigned int* face = &mesh->get_face(i).x;
+    const float3& p0 = mesh->get_position(face[0]);
+    float3 face_normal = normalize(cross(mesh->get_position(face[1]) - p0, mesh->get_position(face[2]) - p0));
+    for(unsigned int j = 0; j < 3; ++j)
+    {
+      const float3& vert = mesh->get_position(face[j]);
+      float3 norm = mesh->has_normals() ? mesh->get_normal(face[j]) : face_normal;
+      uchar4& shade = shades[face[j]];
+      if(shade.w == 0)
+      {
+        float3 color = make_float3(0.5f);
+        const ObjMaterial* m = &materials[mesh->get_material_index(i)];
+        unsigned int model = m->illum;
+        if(model < shaders.size() && shaders[model])
+        {
+          float3 ray_vec = vert - cam->get_position();
+          Ray r(cam->get_position(), normalize(ray_vec), 0, 0.0f);
+          HitInfo hit;
+          hit.has_hit = true;
+          hit.dist = length(ray_vec);
+          hit.position = vert;
+          hit.shading_normal = norm;
+          hit.material = m;
+          color = clamp(shaders[model]->shade(r, hit), 0.0f, 1.0f);
+        }
+        shade = make_uchar4(static_cast<unsigned char>(color.x*255.0f + 0.5f), 
+                            static_cast<unsigned char>(color.y*255.0f + 0.5f),
+                            static_cast<unsigned char>(color.z*255.0f + 0.5f), 255);
+      }
+      glColor3ub(shade.x, shade.y, shade.z);
+      glNormal3fv(&norm.x);
+      glVertex3fv(&vert.x);
+    }
+    if(faces > 100 && (i + 1) % (faces/10) == 0)
+      cout << ".";
+  }
+  glEnd();
+}
+
+void Scene::draw_instance(const Instance* instance, unsigned int disp_list) const
+{
+  // Instanced meshes are shaded in object space. OpenGL matrices are column major.
+  Matrix4x4 m = instance->get_transform().transpose();
+  glPushMatrix();
+  glMultMatrixf(m.getData());
+  glCallList(disp_list);
+  glPopMatrix();
+}
+
 void Scene::draw_plane(const Plane* plane)
 {
   if(!plane)
@@ -363,7 +766,7 @@ void Scene::draw_plane(const Plane* plane)
     hit.material = m;
     shade = shaders[model]->shade(r, hit);
   }
-  const Texture* tex = do_textures && m->has_texture ? textures[m->tex_name] : 0;
+  const Texture* tex = do_textures && m->tex_id >= 0 ? textures[m->tex_id] : 0;
   if(tex)
   {
     tex->enable();
@@ -12,6 +12,10 @@
 #include "ObjMaterial.h"
 #include "Object3D.h"
 #include "TriMesh.h"
+#include "CompactTriMesh.h"
+#include "OutOfCoreMesh.h"
+#include "OutOfCoreCache.h"
+#include "Instance.h"
 #include "Plane.h"
 #include "Sphere.h"
 #include "Triangle.h"
@@ -19,7 +23,9 @@
 #include "Shader.h"
 #include "HitInfo.h"
 #include "BspTree.h"
+#include "Bvh.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 class Light;
 class RayTracer;
@@ -27,7 +33,9 @@ class RayTracer;
 class Scene
 {
 public:
-  Scene(Camera* c) : cam(c), shaders(10, static_cast<Shader*>(0)), redraw(true), do_textures(false) { }
+  Scene(Camera* c) 
+    : active_acc(&acc), cam(c), shaders(10, static_cast<Shader*>(0)), redraw(true), do_textures(false), compact(false), two_level(false), tiled_textures(true), byte_texels(false), opengl_textures(true) 
+  { }
   ~Scene();
 
   // Accessors
@@ -37,16 +45,55 @@ public:
   const Shader* get_shader(const HitInfo& hit) const;
   Camera* get_camera() { return cam; }
   void get_bsphere(optix::float3& c, float& r) const;
-  std::map<std::string, Texture*>& get_textures() { return textures; }
+  const std::vector<Texture*>& get_textures() const { return textures; }
 
   // Loaders
   void load_mesh(const std::string& filename, const optix::Matrix4x4& transform = optix::Matrix4x4::identity());
-  void load_texture(const ObjMaterial& mat, bool is_sphere = false);
   void load_textures();
+
+  // Texel storage of textures loaded after this call (see Texture.h)
+  void set_texture_storage(bool tiled, bool bytes) { tiled_textures = tiled; byte_texels = bytes; }
+
+  // Make OpenGL textures for drawing of textures loaded after this call (needs a window)
+  void set_opengl_textures(bool enable) { opengl_textures = enable; }
+
+  // Load textures at their first look-up and keep at most budget bytes of
+  // texels in memory between frames (0 loads all textures up front).
+  // Call trim_textures() after each frame to evict unused textures.
+  void set_texture_budget(size_t budget) { texture_cache.set_budget(budget); }
+  void trim_textures() { texture_cache.trim(); }
+  const TextureCache& get_texture_cache() const { return texture_cache; }
   void add_plane(const optix::float3& position, const optix::float3& normal, const std::string& mtl_file, unsigned int idx = 0, float tex_scale = 1.0f);
   void add_sphere(const optix::float3& center, float radius, const std::string& mtl_file, unsigned int idx = 0);
   void add_triangle(const optix::float3& v0, const optix::float3& v1, const optix::float3& v2, const std::string& mtl_file, unsigned int idx = 0);
 
+  // Instancing: each mesh file is loaded once and shared by all its instances.
+  // An instance file has one instance per line, a mesh file name (relative to
+  // the instance file) optionally followed by the 12 entries of the first three
+  // rows of the transformation matrix.
+  void add_instance(const std::string& filename, const optix::Matrix4x4& transform);
+  void load_instances(const std::string& filename);
+
+  // Replace meshes by compact versions when the accelerator is built.
+  // Area lights must be extracted before this.
+  void set_compact_meshes(bool enable) { compact = enable; }
+
+  // Keep meshes loaded after this call in memory-mapped files with at most
+  // budget bytes of triangle data resident for all these meshes together
+  // (0 loads meshes into memory).
+  void set_out_of_core_budget(size_t budget) { out_of_core_cache.set_budget(budget); }
+  const OutOfCoreCache& get_out_of_core_cache() const { return out_of_core_cache; }
+
+  // Two-level acceleration: every mesh gets a BVH of its own and is placed
+  // in a top-level BVH over the objects of the scene. Meshes (numbered in
+  // the order they were loaded) can then be moved or deformed between frames.
+  // Call update_accelerator() after the changes. Area lights extracted from
+  // a mesh follow its transformation, but not its deformation.
+  void set_two_level_accelerator(bool enable) { two_level = enable; }
+  void set_mesh_transform(unsigned int mesh_idx, const optix::Matrix4x4& transform);
+  void set_mesh_vertices(unsigned int mesh_idx, const std::vector<optix::float3>& vertices);
+  void update_accelerator();
+
   // Light handling
   void add_light(Light* light) { if(light) lights.push_back(light); }
   unsigned int extract_area_lights(RayTracer* tracer, unsigned int samples_per_light = 1);
@@ -60,34 +107,80 @@ public:
 
   // Ray intersection
   void init_accelerator();
-  bool closest_hit(optix::Ray& r, HitInfo& hit) const { return acc.closest_hit(r, hit); }
-  bool any_hit(optix::Ray& r, HitInfo& hit) const { return acc.any_hit(r, hit); }
+  bool closest_hit(optix::Ray& r, HitInfo& hit) const
+  {
+    // Surface attributes are computed for the closest hit only
+    if(!active_acc->closest_hit(r, hit))
+      return false;
+    hit.object->compute_hit_attributes(r, hit);
+    return true;
+  }
+  bool any_hit(optix::Ray& r, HitInfo& hit) const { return active_acc->any_hit(r, hit); }
 
   // Material classification
   bool is_specular(const ObjMaterial* m) const;
 
 private:
+  TriMesh* read_mesh(const std::string& filename, const optix::Matrix4x4& transform);
+  bool load_out_of_core_mesh(const std::string& filename, const optix::Matrix4x4& transform);
+  void add_area_light(TriMesh* mesh, unsigned int mesh_idx, RayTracer* tracer, unsigned int samples_per_light);
+  void update_area_lights();
+  unsigned int get_mesh_idx(const Object3D* mesh) const;
+  void init_two_level_accelerator();
   void draw_mesh(const TriMesh* mesh) const;
+  void draw_compact_mesh(const CompactTriMesh* mesh) const;
+  void draw_instance(const Instance* instance, unsigned int disp_list) const;
   void draw_plane(const Plane* plane);
   void draw_sphere(const Sphere* sphere) const;
   void draw_triangle(const Triangle* triangle) const;
 
-  std::map<std::string, Texture*> textures;
+  // Textures are numbered when the materials using them are added to the
+  // scene and loaded by load_textures(). The index is -1 without a texture.
+  int add_texture(const ObjMaterial& mat, bool is_sphere = false);
+  void add_material_textures(std::vector<ObjMaterial>& materials);
+
+  std::vector<Texture*> textures;
+  std::map<std::string, int> texture_ids;
+  std::vector<std::pair<std::string, bool> > texture_files;  // File name and whether it is a sphere map
+  TextureCache texture_cache;
   std::vector<Light*> lights;
-  std::vector<const TriMesh*> light_meshes;
+  std::vector<TriMesh*> light_meshes;
   std::vector<unsigned int> extracted_lights;
+  std::vector<unsigned int> light_mesh_ids;                       // Mesh each light was extracted from
+  std::vector<std::vector<optix::float3> > light_rest_vertices;   // Light geometry before mesh transformation
+  std::vector<std::vector<optix::float3> > light_rest_normals;
   std::vector<const TriMesh*> meshes;
+  std::vector<std::string> mesh_files;
+  std::vector<const CompactTriMesh*> compact_meshes;
+  std::vector<const OutOfCoreMesh*> out_of_core_meshes;
+  OutOfCoreCache out_of_core_cache;
+  std::vector<const TriMesh*> instanced_meshes;
+  std::vector<BspTree*> instanced_accs;
+  std::vector<unsigned int> instanced_lists;
+  std::map<std::string, unsigned int> instanced_mesh_ids;
+  std::vector<const Instance*> instances;
+  std::vector<unsigned int> instance_mesh_ids;
   std::vector<const Plane*> planes;
   std::vector<const Sphere*> spheres;
   std::vector<const Triangle*> triangles;
   std::vector<Object3D*> objects;
   std::vector<optix::Matrix4x4> transforms;
   BspTree acc;
+  Bvh top_level_acc;
+  std::vector<Object3D*> top_level_objects;
+  std::vector<Bvh*> mesh_accs;
+  std::vector<Instance*> mesh_instances;
+  const Accelerator* active_acc;
   optix::Aabb bbox;
   Camera* cam;
   std::vector<Shader*> shaders;
   bool redraw;
   bool do_textures;
+  bool compact;
+  bool two_level;
+  bool tiled_textures;
+  bool byte_texels;
+  bool opengl_textures;
 };
 
 #endif // SCENE_H
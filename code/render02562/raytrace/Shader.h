@@ -12,6 +12,9 @@ class Shader
 {
 public:
   virtual optix::float3 shade(const optix::Ray& r, HitInfo& hit, bool emit = true) const = 0;
+
+  /// Reflectance used as albedo output for denoising (white for specular materials)
+  virtual optix::float3 get_albedo(const HitInfo& hit) const { return optix::make_float3(1.0f); }
 };
 
 #endif // SHADER_H
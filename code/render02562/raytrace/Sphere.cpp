@@ -17,11 +17,10 @@ bool Sphere::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     //
     // Output: hit.has_hit          (set true if the ray intersects the sphere)
     //         hit.dist             (distance from the ray origin to the intersection point)
-    //         hit.position         (coordinates of the intersection point)
-    //         hit.geometric_normal (the normalized normal of the sphere)
-    //         hit.shading_normal   (the normalized normal of the sphere)
-    //         hit.material         (pointer to the material of the sphere)
-    //        (hit.texcoord)        (texture coordinates of intersection point, not needed for Week 1)
+    //         hit.object           (pointer to this sphere)
+    //
+    // The remaining hit info is computed in compute_hit_attributes(...)
+    // for the closest hit only.
     //
     // Return: True if the ray intersects the sphere, false otherwise
     //
@@ -61,12 +60,18 @@ bool Sphere::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
 
     hit.has_hit = true;
     hit.dist = dist;
-    hit.position = r.origin + r.direction*dist;
+    hit.object = this;
+    hit.prim_idx = prim_idx;
+
+    return true;
+}
+
+void Sphere::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    hit.position = r.origin + r.direction*hit.dist;
     hit.geometric_normal = normalize(hit.position - center);
     hit.shading_normal = hit.geometric_normal;
     hit.material = &material;
-
-    return true;
 }
 
 void Sphere::transform(const Matrix4x4& m)
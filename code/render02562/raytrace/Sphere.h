@@ -18,6 +18,7 @@ public:
   { }
 
   virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int prim_idx) const;
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const;
   virtual void transform(const optix::Matrix4x4& m);
   virtual optix::Aabb compute_bbox() const;
   virtual void compute_bsphere(optix::float3& bcenter, float& bradius) const
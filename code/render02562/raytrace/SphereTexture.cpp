@@ -26,8 +26,46 @@ float4 SphereTexture::sample_linear(const float3& d) const
   return Texture::sample_linear(make_float3(u, v, 0.0f));
 }
 
+float4 SphereTexture::sample_trilinear(const float3& d, const float2& dtdx, const float2& dtdy) const
+{
+  float u, v;
+  project_direction(d, u, v);
+  return Texture::sample_trilinear(make_float3(u, v, 0.0f), dtdx, dtdy);
+}
+
 void SphereTexture::project_direction(const float3& d, float& u, float& v) const
 {
   // Implement the angular map from direction to texture uv-coordinates.
   // Remember to handle the singularity.
+
+  // The center of the map is the -z direction and the distance from the
+  // center is proportional to the angle to -z
+  float sin_theta = sqrt(d.x*d.x + d.y*d.y);
+  if(sin_theta <= 0.0f)
+  {
+    u = 0.5f;
+    v = d.z < 0.0f ? 0.5f : 1.0f;
+    return;
+  }
+  float r = acos(optix::clamp(-d.z, -1.0f, 1.0f))/(M_PIf*sin_theta);
+  u = 0.5f*(1.0f + d.x*r);
+  v = 0.5f*(1.0f + d.y*r);
+}
+
+float SphereTexture::unproject_direction(float u, float v, float3& d) const
+{
+  float x = 2.0f*u - 1.0f;
+  float y = 2.0f*v - 1.0f;
+  float r = sqrt(x*x + y*y);
+  if(r > 1.0f)
+    return 0.0f;
+
+  // dw = sin(theta) dtheta dphi and theta = pi r, while du dv = r dr dphi/4
+  float theta = M_PIf*r;
+  float sin_theta = sin(theta);
+  if(r > 0.0f)
+    d = make_float3(sin_theta*x/r, sin_theta*y/r, -cos(theta));
+  else
+    d = make_float3(0.0f, 0.0f, -1.0f);
+  return r > 1.0e-6f ? 4.0f*M_PIf*sin_theta/r : 4.0f*M_PIf*M_PIf;
 }
@@ -13,7 +13,16 @@ class SphereTexture : public HDRTexture
 public:
   virtual optix::float4 sample_nearest(const optix::float3& direction) const;
   virtual optix::float4 sample_linear(const optix::float3& direction) const;
+
+  // The direction is projected to the map, while the footprint is given in
+  // texture space (zero for a bilinear look-up)
+  virtual optix::float4 sample_trilinear(const optix::float3& direction, const optix::float2& dtdx, const optix::float2& dtdy) const;
   virtual void project_direction(const optix::float3& d, float& u, float& v) const;
+
+  // Direction corresponding to the texture coordinates u and v (the inverse
+  // of project_direction). Returns the solid angle per unit area of texture
+  // space at (u, v), or zero if (u, v) is outside the map.
+  virtual float unproject_direction(float u, float v, optix::float3& d) const;
 };
 
 #endif // SPHERETEXTURE_H
@@ -3,30 +3,31 @@
 // Copyright (c) DTU Informatics 2011
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <optix_world.h>
 #include "my_glut.h"
 #include "../SOIL/SOIL.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 using namespace std;
 using namespace optix;
 
 void Texture::load(const char* filename)
 {
-    SOIL_free_image_data(data);
-    data = SOIL_load_image(filename, &width, &height, &channels, SOIL_LOAD_AUTO);
-    if(!data)
-    {
-        cerr << "Error: Could not load texture image file." << endl;
+    if(!decode(filename))
         return;
+    if(opengl)
+    {
+        tex_handle = SOIL_create_OGL_texture(data, width, height, channels, tex_handle, SOIL_FLAG_INVERT_Y | SOIL_FLAG_TEXTURE_REPEATS);
+        tex_target = GL_TEXTURE_2D;
     }
-    int img_size = width*height;
-    delete [] fdata;
-    fdata = new float4[img_size];
-    for(int i = 0; i < img_size; ++i)
-        fdata[i] = look_up(i);
-    tex_handle = SOIL_create_OGL_texture(data, width, height, channels, tex_handle, SOIL_FLAG_INVERT_Y | SOIL_FLAG_TEXTURE_REPEATS);
-    tex_target = GL_TEXTURE_2D;
+
+    // Only the converted texels are used from here on
+    SOIL_free_image_data(data);
+    data = 0;
 }
 
 void Texture::load(GLenum target, GLuint texture)
@@ -34,16 +35,72 @@ void Texture::load(GLenum target, GLuint texture)
     glBindTexture(target, texture);
     glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
     glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
-    delete [] fdata;
-    fdata = new float4[width*height];
-    glGetTexImage(target, 0, GL_RGBA, GL_FLOAT, &fdata[0].x);
+    vector<float4> texels(width*height);
+    glGetTexImage(target, 0, GL_RGBA, GL_FLOAT, &texels[0].x);
+    build_mipmaps(&texels[0], false);
     tex_handle = texture;
     tex_target = target;
 }
 
+void Texture::load_on_demand(const string& filename, TextureCache* texture_cache)
+{
+    clear();
+    source = filename;
+    cache = texture_cache;
+    failed = false;
+}
+
+size_t Texture::get_memory_size() const
+{
+    size_t size = 0;
+    for(unsigned int i = 0; i < mipmap.size(); ++i)
+    {
+        const MipLevel& l = mipmap[i];
+        size_t texels = l.tiles_x ? l.tiles_x*((l.height + tile_size - 1)/tile_size)*tile_size*tile_size : l.width*l.height;
+        size += texels*(l.texels ? sizeof(float4) : sizeof(uchar4));
+    }
+    return size;
+}
+
+bool Texture::decode_source()
+{
+    if(!decode(source.c_str()))
+    {
+        // Do not try again at every look-up
+        #pragma omp atomic write
+        failed = true;
+        return false;
+    }
+    SOIL_free_image_data(data);
+    data = 0;
+    return true;
+}
+
+bool Texture::page_in() const
+{
+    return cache->page_in(const_cast<Texture*>(this));
+}
+
+bool Texture::decode(const char* filename)
+{
+    SOIL_free_image_data(data);
+    data = SOIL_load_image(filename, &width, &height, &channels, SOIL_LOAD_AUTO);
+    if(!data)
+    {
+        cerr << "Error: Could not load texture image file." << endl;
+        return false;
+    }
+    int img_size = width*height;
+    vector<float4> texels(img_size);
+    for(int i = 0; i < img_size; ++i)
+        texels[i] = look_up(i);
+    build_mipmaps(&texels[0], true);
+    return true;
+}
+
 float4 Texture::sample_nearest(const float3& texcoord) const
 {
-    if(!fdata)
+    if(!request())
         return make_float4(0.0f);
 
     // Implement texture look-up of nearest texel.
@@ -53,11 +110,11 @@ float4 Texture::sample_nearest(const float3& texcoord) const
     // Return: texel color found at the given texture coordinates
     //
     // Relevant data fields that are available (see Texture.h)
-    // fdata                 (flat array of texture data: texel colors in float4 format)
+    // mipmap[0]             (full resolution texture: texel colors read by fetch(...))
     // width, height         (texture resolution)
     //
     // Hint: Remember to revert the vertical axis when finding the index
-    //       into fdata.
+    //       into the texture.
     double s, t, a, b;
     int U, V;
     s = texcoord.x - floor(texcoord.x);
@@ -69,13 +126,13 @@ float4 Texture::sample_nearest(const float3& texcoord) const
     U = (int)(a + 0.5) % width;
     V = (int)(b + 0.5) % height;
     // We revert the vertical axis
-    return fdata[U + V*width];
+    return fetch(mipmap[0], U, V);
 //    return make_float4(0.0f);
 }
 
 float4 Texture::sample_linear(const float3& texcoord) const
 {
-    if(!fdata)
+    if(!request())
         return make_float4(0.0f);
 
     // Implement texture look-up which returns the bilinear interpolation of
@@ -87,7 +144,7 @@ float4 Texture::sample_linear(const float3& texcoord) const
     //         bilinear interpolation
     //
     // Relevant data fields that are available (see Texture.h)
-    // fdata                 (flat array of texture data: texel colors in float4 format)
+    // mipmap[0]             (full resolution texture: texel colors read by fetch(...))
     // width, height         (texture resolution)
     //
     // Hint: Use three lerp operations (or one bilerp) to perform the
@@ -107,15 +164,154 @@ float4 Texture::sample_linear(const float3& texcoord) const
     float4 i_a, i_b, i_c, i_d;
     // We need a modulo when taking the U+1 or V+1 coordinate to make sure
     // we're not going outside the texture image
-    i_a = fdata[U + V*width];
-    i_b = fdata[(U+1)%width + V*width];
-    i_c = fdata[U + ((V+1)%height)*width];
-    i_d = fdata[(U+1)%width + ((V+1)%height)*width];
+    const MipLevel& level = mipmap[0];
+    i_a = fetch(level, U, V);
+    i_b = fetch(level, (U+1)%width, V);
+    i_c = fetch(level, U, (V+1)%height);
+    i_d = fetch(level, (U+1)%width, (V+1)%height);
 
     return bilerp(i_a, i_b, i_c, i_d, a - U, b - V);
     //return sample_nearest(texcoord);
 }
 
+float4 Texture::sample_trilinear(const float3& texcoord, const float2& dtdx, const float2& dtdy) const
+{
+    if(!request())
+        return make_float4(0.0f);
+
+    // Select the level where the longest side of the footprint is one texel
+    float2 size = make_float2(static_cast<float>(width), static_cast<float>(height));
+    float footprint = fmaxf(length(dtdx*size), length(dtdy*size));
+    float lod = footprint > 1.0f ? log2f(footprint) : 0.0f;
+    float max_lod = static_cast<float>(mipmap.size() - 1);
+    lod = fminf(lod, max_lod);
+
+    float s = texcoord.x;
+    float t = 1.0f - texcoord.y;
+    unsigned int level = static_cast<unsigned int>(lod);
+    float4 result = sample_level(level, s, t);
+    float f = lod - level;
+    if(f > 0.0f)
+        result = lerp(result, sample_level(level + 1, s, t), f);
+    return result;
+}
+
+void Texture::build_mipmaps(const float4* texels, bool ldr)
+{
+    clear_mipmaps();
+    vector<float4> prev(texels, texels + width*height);
+    int w = width;
+    int h = height;
+    for(;;)
+    {
+        MipLevel level;
+        level.width = w;
+        level.height = h;
+        level.tiles_x = tiled ? (w + tile_size - 1)/tile_size : 0;
+        int size = tiled ? level.tiles_x*((h + tile_size - 1)/tile_size)*tile_size*tile_size : w*h;
+        level.texels = ldr && byte_texels ? 0 : new float4[size];
+        level.bytes = level.texels ? 0 : new uchar4[size];
+        for(int v = 0; v < h; ++v)
+            for(int u = 0; u < w; ++u)
+                store(level, u, v, prev[u + v*w]);
+        mipmap.push_back(level);
+        if(w == 1 && h == 1)
+            break;
+
+        int next_w = max(w/2, 1);
+        int next_h = max(h/2, 1);
+        vector<float4> next(next_w*next_h);
+        for(int v = 0; v < next_h; ++v)
+        {
+            int v0 = min(2*v, h - 1);
+            int v1 = min(2*v + 1, h - 1);
+            for(int u = 0; u < next_w; ++u)
+            {
+                int u0 = min(2*u, w - 1);
+                int u1 = min(2*u + 1, w - 1);
+                next[u + v*next_w] = 0.25f*(prev[u0 + v0*w] + prev[u1 + v0*w] + prev[u0 + v1*w] + prev[u1 + v1*w]);
+            }
+        }
+        prev.swap(next);
+        w = next_w;
+        h = next_h;
+    }
+
+    // Publish the texels before the residency (see is_resident())
+    #pragma omp atomic write seq_cst
+    resident = true;
+}
+
+void Texture::clear_mipmaps()
+{
+    for(unsigned int i = 0; i < mipmap.size(); ++i)
+    {
+        delete [] mipmap[i].texels;
+        delete [] mipmap[i].bytes;
+    }
+    mipmap.clear();
+    #pragma omp atomic write seq_cst
+    resident = false;
+}
+
+float4 Texture::sample_level(unsigned int level, float s, float t) const
+{
+    const MipLevel& l = mipmap[level];
+    float a = s*l.width - 0.5f;
+    float b = t*l.height - 0.5f;
+    float U = floorf(a);
+    float V = floorf(b);
+    int u = static_cast<int>(U);
+    int v = static_cast<int>(V);
+    return bilerp(fetch(l, u, v), fetch(l, u + 1, v), fetch(l, u, v + 1), fetch(l, u + 1, v + 1), a - U, b - V);
+}
+
+float4 Texture::fetch(const MipLevel& level, int u, int v) const
+{
+    if(clamp)
+    {
+        u = min(max(u, 0), level.width - 1);
+        v = min(max(v, 0), level.height - 1);
+    }
+    else
+    {
+        u %= level.width;
+        v %= level.height;
+        if(u < 0) u += level.width;
+        if(v < 0) v += level.height;
+    }
+    unsigned int idx = texel_index(level, u, v);
+    if(level.texels)
+        return level.texels[idx];
+    const uchar4& c = level.bytes[idx];
+    return make_float4(convert(c.x), convert(c.y), convert(c.z), convert(c.w));
+}
+
+void Texture::store(MipLevel& level, int u, int v, const float4& texel) const
+{
+    unsigned int idx = texel_index(level, u, v);
+    if(level.texels)
+    {
+        level.texels[idx] = texel;
+        return;
+    }
+    // Inverse of convert(...) so that 8-bit image data is stored exactly
+    float4 c = optix::clamp(texel*256.0f, 0.0f, 255.0f);
+    level.bytes[idx] = make_uchar4(static_cast<unsigned char>(c.x), static_cast<unsigned char>(c.y), 
+                                   static_cast<unsigned char>(c.z), static_cast<unsigned char>(c.w));
+}
+
+unsigned int Texture::texel_index(const MipLevel& level, int u, int v) const
+{
+    if(!level.tiles_x)
+        return u + v*level.width;
+
+    // The tiles are stored row by row and so are the texels within a tile
+    unsigned int x = u, y = v;
+    unsigned int tile = (y/tile_size)*level.tiles_x + x/tile_size;
+    return tile*tile_size*tile_size + (y%tile_size)*tile_size + x%tile_size;
+}
+
 float4 Texture::look_up(unsigned int idx) const
 {
     idx *= channels;
@@ -5,15 +5,22 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <string>
+#include <vector>
 #include <optix_world.h>
 #include "my_glut.h"
 #include "../SOIL/SOIL.h"
 
+class TextureCache;
+
 class Texture
 {
 public:
-  Texture() : width(0), height(0), data(0), fdata(0), clamp(false), tex_handle(0), tex_target(GL_TEXTURE_2D) { }
-  ~Texture() { SOIL_free_image_data(data); delete [] fdata; }
+  Texture() 
+    : width(0), height(0), data(0), tex_handle(0), tex_target(GL_TEXTURE_2D), opengl(true), clamp(false), 
+      tiled(true), byte_texels(false), resident(false), failed(false), used(false), cache(0) 
+  { }
+  ~Texture() { SOIL_free_image_data(data); clear_mipmaps(); }
 
   // Load texture from file
   void load(const char* filename);
@@ -21,16 +28,61 @@ public:
   // Load texture from OpenGL texture
   void load(GLenum target, GLuint texture);
 
-  // Clear texture data
-  void clear() { SOIL_free_image_data(data); data = 0; delete [] fdata; fdata = 0; }
+  // Load texture from file at the first look-up. The texture cache keeps
+  // track of the memory used and may evict the texels again between frames.
+  // Textures loaded on demand are not available for OpenGL drawing.
+  void load_on_demand(const std::string& filename, TextureCache* texture_cache);
 
-  // Was a texture loaded yet
-  bool has_texture() const { return fdata != 0; }
+  // Clear texture data
+  void clear() { SOIL_free_image_data(data); data = 0; clear_mipmaps(); }
+
+  // Was a texture loaded yet (or will it be loaded on demand)
+  bool has_texture() const { return is_resident() || (cache != 0 && !has_failed()); }
+
+  // Are the texels in memory. Residency is published after the mipmap is
+  // stored, so a thread that finds the texture resident also sees its texels.
+  bool is_resident() const
+  {
+    bool flag;
+    #pragma omp atomic read seq_cst
+    flag = resident;
+    return flag;
+  }
+
+  // Bytes used by the texels of all mipmap levels
+  size_t get_memory_size() const;
+
+  // Used by the texture cache
+  bool decode_source();
+  void evict() { clear_mipmaps(); }
+  bool reset_used() { bool was_used = used; used = false; return was_used; }
+
+  // Texel storage (set before loading). Tiled storage keeps the texels of
+  // each 8x8 block together in memory. Byte texels store low dynamic range
+  // images with 8 bits per channel instead of a float4 per texel.
+  void set_tiled(bool enable) { tiled = enable; }
+  void set_byte_texels(bool enable) { byte_texels = enable; }
+
+  // Also make an OpenGL texture for drawing when loading from a file (needs
+  // an OpenGL context)
+  void set_opengl(bool enable) { opengl = enable; }
 
   // Look up the texel using texture space coordinates
   virtual optix::float4 sample_nearest(const optix::float3& texcoord) const;
   virtual optix::float4 sample_linear(const optix::float3& texcoord) const;
 
+  // Trilinear look-up in the mipmap using the texture coordinate differentials
+  // of the footprint. A zero footprint gives a bilinear look-up in the full
+  // resolution texture.
+  virtual optix::float4 sample_trilinear(const optix::float3& texcoord, const optix::float2& dtdx, const optix::float2& dtdy) const;
+
+  // Resolution of the full resolution texture
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+
+  // Number of levels in the mipmap (the full resolution texture is level 0)
+  unsigned int no_of_levels() const { return mipmap.size(); }
+
   // Clamp the texture
   void clamp_to_edge() { clamp = true; }
 
@@ -43,26 +95,90 @@ public:
   void disable() const { glDisable(tex_target); }
 
 protected:
+  // Make sure that the texels are in memory before a look-up
+  bool request() const
+  {
+    bool flag;
+    #pragma omp atomic read
+    flag = used;
+    if(!flag)
+    {
+      #pragma omp atomic write
+      used = true;
+    }
+    return is_resident() || (cache && !has_failed() && page_in());
+  }
+  bool page_in() const;
+
+  // A texture that could not be decoded is not requested again
+  bool has_failed() const
+  {
+    bool flag;
+    #pragma omp atomic read
+    flag = failed;
+    return flag;
+  }
+
+  // Load image data and convert it to texels
+  bool decode(const char* filename);
+
+  struct MipLevel
+  {
+    int width;
+    int height;
+    int tiles_x;           // Tiles per row (0 if stored row by row)
+    optix::float4* texels; // Float texels or
+    optix::uchar4* bytes;  // 8-bit texels
+  };
+
+  static const unsigned int tile_size = 8;
+
   optix::float4 look_up(unsigned int idx) const;
   float convert(unsigned char c) const;
 
+  // Store the texels (row by row, top row first) and build the mipmap from
+  // them by repeated 2x2 box filtering. Byte texels are only used for LDR images.
+  void build_mipmaps(const optix::float4* texels, bool ldr);
+  void clear_mipmaps();
+
+  // Bilinear look-up in one level of the mipmap (texel centers at half-integers)
+  optix::float4 sample_level(unsigned int level, float s, float t) const;
+  optix::float4 fetch(const MipLevel& level, int u, int v) const;
+  void store(MipLevel& level, int u, int v, const optix::float4& texel) const;
+  unsigned int texel_index(const MipLevel& level, int u, int v) const;
+
   // Texture dimensions
   int width;
   int height;
 
   // Pointers to image data
   unsigned char* data;
-  optix::float4* fdata;
+
+  // Mipmap levels, level 0 is the full resolution texture
+  std::vector<MipLevel> mipmap;
 
   // OpenGL texture info
   GLuint tex_handle;
   GLenum tex_target;
+  bool opengl;
 
   // If clamp is false the texture is repeated
   bool clamp;
 
   // Bytes per pixel
   int channels;
+
+  // Texel storage
+  bool tiled;
+  bool byte_texels;
+
+  // On-demand loading. The flags are read by render threads while the
+  // texture cache changes them, so they are only accessed atomically.
+  bool resident;
+  bool failed;
+  mutable bool used;
+  TextureCache* cache;
+  std::string source;
 };
 
 #endif // TEXTURE_H
@@ -0,0 +1,50 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <vector>
+#include "Texture.h"
+#include "TextureCache.h"
+
+using namespace std;
+
+bool TextureCache::page_in(Texture* tex)
+{
+    // Several threads may request the same texture. The first one decodes
+    // it, the others wait and find it resident.
+    #pragma omp critical (texture_cache)
+    {
+        if(!tex->is_resident() && tex->decode_source())
+        {
+            resident.push_back(tex);
+            last_use.push_back(frame);
+            used_memory += tex->get_memory_size();
+            ++loads;
+        }
+    }
+    return tex->is_resident();
+}
+
+void TextureCache::trim()
+{
+    // Textures looked up since the last call were used in this frame
+    ++frame;
+    for(unsigned int i = 0; i < resident.size(); ++i)
+        if(resident[i]->reset_used())
+            last_use[i] = frame;
+
+    while(used_memory > budget && !resident.empty())
+    {
+        unsigned int lru = 0;
+        for(unsigned int i = 1; i < resident.size(); ++i)
+            if(last_use[i] < last_use[lru])
+                lru = i;
+        Texture* evicted = resident[lru];
+        used_memory -= evicted->get_memory_size();
+        evicted->evict();
+        resident[lru] = resident.back();
+        resident.pop_back();
+        last_use[lru] = last_use.back();
+        last_use.pop_back();
+    }
+}
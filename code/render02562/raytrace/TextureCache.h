@@ -0,0 +1,42 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <vector>
+
+class Texture;
+
+/** Bookkeeping for textures loaded on demand (see Texture::load_on_demand).
+    A texture is decoded at its first look-up. Render threads may be reading
+    any resident texture, so textures are only evicted by trim(), which
+    should be called between frames. It releases the textures that were
+    least recently used until the memory budget is met. */
+class TextureCache
+{
+public:
+  TextureCache(size_t memory_budget = 0) : budget(memory_budget), used_memory(0), frame(0), loads(0) { }
+
+  void set_budget(size_t memory_budget) { budget = memory_budget; }
+  size_t get_budget() const { return budget; }
+  size_t get_used_memory() const { return used_memory; }
+  unsigned int get_loads() const { return loads; }
+
+  // Decode a texture (called by the texture when it is first looked up)
+  bool page_in(Texture* tex);
+
+  // Evict least recently used textures until the budget is met
+  void trim();
+
+private:
+  size_t budget;
+  size_t used_memory;
+  unsigned int frame;
+  unsigned int loads;
+  std::vector<Texture*> resident;
+  std::vector<unsigned int> last_use;
+};
+
+#endif // TEXTURECACHE_H
@@ -19,14 +19,14 @@ float3 Textured::get_emission(const HitInfo& hit) const
   if(m)
   {
     float3 emission = make_float3(m->ambient[0], m->ambient[1], m->ambient[2]);
-    const Texture* tex = m->has_texture ? (*texs)[m->tex_name] : 0;
+    const Texture* tex = m->tex_id >= 0 ? (*texs)[m->tex_id] : 0;
     if(tex && tex->has_texture())
     {
       float3 reduced_emission;
       reduced_emission.x = m->diffuse[0] > 0.0f ? emission.x/m->diffuse[0] : 0.0f;
       reduced_emission.y = m->diffuse[1] > 0.0f ? emission.y/m->diffuse[1] : 0.0f;
       reduced_emission.z = m->diffuse[2] > 0.0f ? emission.z/m->diffuse[2] : 0.0f;
-      return reduced_emission*make_float3(tex->sample_linear(hit.texcoord));
+      return reduced_emission*make_float3(tex->sample_trilinear(hit.texcoord, hit.texcoord_dx, hit.texcoord_dy));
     }
     return emission;
   }
@@ -41,9 +41,9 @@ float3 Textured::get_diffuse(const HitInfo& hit) const
   const ObjMaterial* m = hit.material;
   if(m)
   {
-    const Texture* tex = m->has_texture ? (*texs)[m->tex_name] : 0;
+    const Texture* tex = m->tex_id >= 0 ? (*texs)[m->tex_id] : 0;
     if(tex && tex->has_texture())
-      return make_float3(tex->sample_linear(hit.texcoord));      
+      return make_float3(tex->sample_trilinear(hit.texcoord, hit.texcoord_dx, hit.texcoord_dy));      
     return make_float3(m->diffuse[0], m->diffuse[1], m->diffuse[2]);
   }
   return make_float3(0.8f);
@@ -5,8 +5,7 @@
 #ifndef TEXTURED_H
 #define TEXTURED_H
 
-#include <map>
-#include <string>
+#include <vector>
 #include <optix_world.h>
 #include "HitInfo.h"
 #include "Texture.h"
@@ -19,13 +18,14 @@ class Textured : public Reflectance
 public:
   Textured() : texs(0) { }
 
-  void set_textures(std::map<std::string, Texture*>& textures) { texs = &textures; }
+  // Materials refer to textures by their index in this table (ObjMaterial::tex_id)
+  void set_textures(const std::vector<Texture*>& textures) { texs = &textures; }
 
 protected:
   virtual optix::float3 get_emission(const HitInfo& hit) const;
   virtual optix::float3 get_diffuse(const HitInfo& hit) const;
 
-  std::map<std::string, Texture*>* texs;
+  const std::vector<Texture*>* texs;
 };
 
 #endif // TEXTURED_H
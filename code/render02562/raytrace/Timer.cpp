@@ -0,0 +1,74 @@
+// Simplistic stop watch (Timer) and tool for measuring 
+// frames per second (FrameRateTimer).
+//
+// Code written by Jeppe Revall Frisvad
+// Copyright (c) DTU Informatics 2009
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+#include "Timer.h"
+
+namespace
+{
+#ifdef _WIN32
+  // FILETIME counts 100 nanosecond intervals
+  long long filetime_ns(const FILETIME& t)
+  {
+    ULARGE_INTEGER u;
+    u.LowPart = t.dwLowDateTime;
+    u.HighPart = t.dwHighDateTime;
+    return static_cast<long long>(u.QuadPart)*100;
+  }
+#else
+  long long clock_ns(clockid_t id)
+  {
+    timespec ts;
+    if(clock_gettime(id, &ts) != 0)
+      return 0;
+    return ts.tv_sec*1000000000LL + ts.tv_nsec;
+  }
+#endif
+}
+
+long long Timer::wall_clock_ns()
+{
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  long long seconds = count.QuadPart/frequency.QuadPart;
+  long long rest = count.QuadPart%frequency.QuadPart;
+  return seconds*1000000000LL + rest*1000000000LL/frequency.QuadPart;
+#else
+  return clock_ns(CLOCK_MONOTONIC);
+#endif
+}
+
+long long Timer::process_cpu_ns()
+{
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    return 0;
+  return filetime_ns(kernel) + filetime_ns(user);
+#else
+  return clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+#endif
+}
+
+long long Timer::thread_cpu_ns()
+{
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    return 0;
+  return filetime_ns(kernel) + filetime_ns(user);
+#else
+  return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+#endif
+}
@@ -7,36 +7,98 @@
 #ifndef TIMER_H
 #define TIMER_H
 
-#include <ctime>
-
+// Times are measured in nanoseconds by a monotonic wall clock. The CPU
+// time used by the process (all threads) and by the thread calling start
+// and stop is measured alongside. Their ratio to the wall clock time tells
+// how well the work was spread over the threads.
 class Timer
 {
  public:
-  Timer() : t1(0), t2(0) { }
+  Timer() : t1(0), t2(0), cpu1(0), cpu2(0), thread1(0), thread2(0) { }
   
   void start(double from_time = 0.0)
   {
-    t1 = static_cast<int>(std::clock() - from_time*static_cast<double>(CLOCKS_PER_SEC));
+    t1 = wall_clock_ns() - static_cast<long long>(from_time*1.0e9);
+    cpu1 = process_cpu_ns();
+    thread1 = thread_cpu_ns();
   }
 
-  double split()
+  double split() const
   {
-    return (std::clock() - t1) / static_cast<double>(CLOCKS_PER_SEC);
+    return (wall_clock_ns() - t1)*1.0e-9;
   }
 
   void stop()
   {
-    t2 = std::clock();
+    t2 = wall_clock_ns();
+    cpu2 = process_cpu_ns();
+    thread2 = thread_cpu_ns();
   }
   
-  double get_time()
+  // Wall clock time between start and stop
+  double get_time() const
+  {
+    return (t2 - t1)*1.0e-9;
+  }
+
+  // CPU time of all threads in the process between start and stop
+  double get_cpu_time() const
+  {
+    return (cpu2 - cpu1)*1.0e-9;
+  }
+
+  // CPU time of the thread that called start and stop
+  double get_thread_time() const
+  {
+    return (thread2 - thread1)*1.0e-9;
+  }
+
+  // Average number of busy threads between start and stop
+  double get_utilization() const
+  {
+    return t2 > t1 ? (cpu2 - cpu1)/static_cast<double>(t2 - t1) : 0.0;
+  }
+
+  static long long wall_clock_ns();
+  static long long process_cpu_ns();
+  static long long thread_cpu_ns();
+
+ private:
+  long long t1;
+  long long t2;
+  long long cpu1;
+  long long cpu2;
+  long long thread1;
+  long long thread2;
+};
+
+// Times a scope, e.g. a function with several exits or the part of a 
+// parallel region run by one thread. The wall clock time is added to 
+// seconds and the CPU time of the thread to thread_seconds (if given).
+class ScopedTimer
+{
+ public:
+  ScopedTimer(double& seconds, double* thread_seconds = 0)
+    : total(seconds), thread_total(thread_seconds)
+  { 
+    timer.start();
+  }
+
+  ~ScopedTimer()
   {
-    return (t2 - t1) / static_cast<double>(CLOCKS_PER_SEC);
+    timer.stop();
+    total += timer.get_time();
+    if(thread_total)
+      *thread_total += timer.get_thread_time();
   }
 
  private:
-  int t1;
-  int t2;
+  ScopedTimer(const ScopedTimer&);
+  ScopedTimer& operator=(const ScopedTimer&);
+
+  Timer timer;
+  double& total;
+  double* thread_total;
 };
 
 class FrameRateTimer : public Timer
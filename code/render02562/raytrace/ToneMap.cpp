@@ -0,0 +1,24 @@
+// 02566 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2009
+// Copyright (c) DTU Informatics 2009
+
+#include <vector>
+#include <algorithm>
+#include "ToneMap.h"
+
+using namespace std;
+
+void ToneMap::apply_to_bytes(const float* data, unsigned char* out, unsigned int w, unsigned int h, unsigned int channels) const
+{
+  unsigned int row_size = w*channels;
+  #pragma omp parallel for
+  for(int j = 0; j < static_cast<int>(h); ++j)
+  {
+    const float* in_row = data + (h - j - 1)*row_size;
+    vector<float> row(in_row, in_row + row_size);
+    apply(&row[0], w, 1, channels);
+    unsigned char* out_row = out + j*row_size;
+    for(unsigned int i = 0; i < row_size; ++i)
+      out_row[i] = static_cast<unsigned char>(min(max(row[i], 0.0f), 1.0f)*255.0f + 0.5f);
+  }
+}
@@ -10,6 +10,10 @@ class ToneMap
 public:
   virtual void apply(float* data, unsigned int width, unsigned int height, unsigned int channels) const = 0;
   virtual void unapply(float* data, unsigned int width, unsigned int height, unsigned int channels) const = 0;
+
+  // Tone map and convert to 8 bits per channel in one pass. The rows are
+  // written bottom-up (the order of image files) and data is unchanged.
+  virtual void apply_to_bytes(const float* data, unsigned char* out, unsigned int width, unsigned int height, unsigned int channels) const;
 };
 
 #endif // TONEMAP_H
@@ -14,6 +14,7 @@
 #include "Object3D.h"
 #include "Triangle.h"
 #include "TriMesh.h"
+#include "ray_differentials.h"
 
 using namespace std;
 using namespace optix;
@@ -29,30 +30,14 @@ bool TriMesh::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     //
     // Output: hit.has_hit          (set true if the ray intersects the triangle)
     //         hit.dist             (distance from the ray origin to the intersection point)
-    //         hit.position         (coordinates of the intersection point)
-    //         hit.geometric_normal (the normalized normal of the triangle)
-    //         hit.shading_normal   (the normalized normal of the triangle)
-    //         hit.material         (pointer to the material of the triangle)
-    //        (hit.texcoord)        (texture coordinates of intersection point)
+    //         hit.object           (pointer to this mesh)
+    //         hit.prim_idx         (index of the intersected triangle)
+    //         hit.barycentrics     (barycentric coordinates v and w of the intersection point)
     //
     // Return: True if the ray intersects the triangle, false otherwise
     //
-    // Relevant data fields that are available (see TriMesh.h and above)
-    // r                            (the ray)
-    // face                         (triangle vertex indices)
-    // geometry                     (indexed face set containing vertex positions)
-    // normals                      (indexed face set containing vertex normals)
-    // texcoords                    (indexed face set containing vertex texture coordinates)
-    // mat_idx                      (array containing material index for each triangle)
-    // materials                    (array of materials)
-    //
-    // Hints: (a) Use the function intersect_triangle(...) to get the hit info.
-    //        (b) Use the barycentric coordinates of the intersection point
-    //        to interpolate the normal (and texture coordinates, if needed)
-    //        linearly across the triangle.
-    //        (c) Use the function has_normals() to check if the mesh has
-    //        vertex normals for computing the shading normal. If not, use
-    //        the geometric normal as shading normal.
+    // Normals, texture coordinates, and material are only needed for the
+    // closest hit and are computed in compute_hit_attributes(...).
     float3 v0 = geometry.vertex(face.x);
     float3 v1 = geometry.vertex(face.y);
     float3 v2 = geometry.vertex(face.z);
@@ -64,25 +49,50 @@ bool TriMesh::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) const
     if (intersects) {
         hit.has_hit = true;
         hit.dist = dist;
-        hit.geometric_normal = normalize(normal);
-
-        if (has_normals()) {
-            uint3 normals_idx = normals.face(prim_idx);
-            float3 n1 = normals.vertex(normals_idx.x);
-            float3 n2 = normals.vertex(normals_idx.y);
-            float3 n3 = normals.vertex(normals_idx.z);
-            float3 interp_normal = normalize((1-v-w)*n1 + v*n2 + w*n3);
-            hit.shading_normal = interp_normal;
-        } else {
-            hit.shading_normal = hit.geometric_normal;
-        }
-
-        hit.material = &(materials[mat_idx[prim_idx]]);
-        hit.position = r.origin + r.direction*dist;
+        hit.object = this;
+        hit.prim_idx = prim_idx;
+        hit.barycentrics = make_float2(v, w);
     }
     return intersects;
 }
 
+void TriMesh::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    // Use the barycentric coordinates of the intersection point
+    // to interpolate the normal and texture coordinates linearly
+    // across the triangle. If the mesh has no vertex normals, the
+    // geometric normal is used as shading normal.
+    unsigned int prim_idx = hit.prim_idx;
+    float v = hit.barycentrics.x;
+    float w = hit.barycentrics.y;
+    const uint3& face = geometry.face(prim_idx);
+    const float3& v0 = geometry.vertex(face.x);
+    hit.geometric_normal = normalize(cross(geometry.vertex(face.y) - v0, geometry.vertex(face.z) - v0));
+
+    if (has_normals()) {
+        uint3 normals_idx = normals.face(prim_idx);
+        float3 n1 = normals.vertex(normals_idx.x);
+        float3 n2 = normals.vertex(normals_idx.y);
+        float3 n3 = normals.vertex(normals_idx.z);
+        hit.shading_normal = normalize((1-v-w)*n1 + v*n2 + w*n3);
+    } else {
+        hit.shading_normal = hit.geometric_normal;
+    }
+
+    if (texcoords.no_faces() > prim_idx) {
+        uint3 texcoords_idx = texcoords.face(prim_idx);
+        const float3& t0 = texcoords.vertex(texcoords_idx.x);
+        const float3& t1 = texcoords.vertex(texcoords_idx.y);
+        const float3& t2 = texcoords.vertex(texcoords_idx.z);
+        hit.texcoord = (1-v-w)*t0 + v*t1 + w*t2;
+        compute_texcoord_differentials(r, hit, v0, geometry.vertex(face.y), geometry.vertex(face.z),
+                                       make_float2(t0), make_float2(t1), make_float2(t2));
+    }
+
+    hit.material = &(materials[mat_idx[prim_idx]]);
+    hit.position = r.origin + r.direction*hit.dist;
+}
+
 void TriMesh::transform(const Matrix4x4& m)
 {
     for(unsigned int i = 0; i < geometry.no_vertices(); ++i)
@@ -190,4 +200,5 @@ void TriMesh::compute_areas()
     if(surface_area > 0.0f)
         for(int i = 0; i < no_of_faces; ++i)
             face_area_cdf[i] /= surface_area;
+    face_area_table.build(face_areas);
 }
@@ -14,6 +14,7 @@
 #include "ObjMaterial.h"
 #include "HitInfo.h"
 #include "Object3D.h"
+#include "AliasTable.h"
 
 /** \brief A Triangle Mesh struct. 
 
@@ -56,6 +57,9 @@ class TriMesh : public Object3D
   /// Tabulated cumulative distribution function for sampling triangles according to area
   std::vector<float> face_area_cdf;
 
+  /// Alias table for sampling triangles according to area in constant time
+  AliasTable face_area_table;
+
   /// Total surface area of the triangle mesh
   float surface_area;
 
@@ -64,6 +68,9 @@ class TriMesh : public Object3D
   /// Compute intersection of ray with a triangle in the mesh
   virtual bool intersect(const optix::Ray& r, HitInfo& hit, unsigned int prim_idx) const;
 
+  /// Compute position, normals, texture coordinates, and material of a hit
+  virtual void compute_hit_attributes(const optix::Ray& r, HitInfo& hit) const;
+
   /// Apply a transformation matrix to the mesh
   virtual void transform(const optix::Matrix4x4& m);
 
@@ -90,6 +97,9 @@ class TriMesh : public Object3D
 
   /// Compute areas for all faces and total surface area.
   void compute_areas();
+
+  /// Choose a triangle with probability proportional to its area using xi in [0,1).
+  unsigned int sample_face(double xi) const { return face_area_table.sample(xi); }
 };
 
 #endif // TRIMESH_H
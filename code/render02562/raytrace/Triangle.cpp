@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include "HitInfo.h"
 #include "Triangle.h"
+#include "ray_differentials.h"
 
 using namespace optix;
 
@@ -62,11 +63,11 @@ bool Triangle::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) cons
     //
     // Output: hit.has_hit          (set true if the ray intersects the triangle)
     //         hit.dist             (distance from the ray origin to the intersection point)
-    //         hit.position         (coordinates of the intersection point)
-    //         hit.geometric_normal (the normalized normal of the triangle)
-    //         hit.shading_normal   (the normalized normal of the triangle)
-    //         hit.material         (pointer to the material of the triangle)
-    //        (hit.texcoord)        (texture coordinates of intersection point, not needed for Week 1)
+    //         hit.object           (pointer to this triangle)
+    //         hit.barycentrics     (barycentric coordinates v and w of the intersection point)
+    //
+    // The remaining hit info is computed in compute_hit_attributes(...)
+    // for the closest hit only.
     //
     // Return: True if the ray intersects the triangle, false otherwise
     //
@@ -93,15 +94,26 @@ bool Triangle::intersect(const Ray& r, HitInfo& hit, unsigned int prim_idx) cons
 //        printf("Optix : %f - %f - %f - %f, %f, %f\n",distbis, vbis, wbis, normalbis.x, normalbis.y, normalbis.z);
         hit.has_hit = true;
         hit.dist = dist;
-        hit.position = r.origin + r.direction*dist;
-        hit.geometric_normal = normalize(normal);
-        hit.shading_normal = hit.geometric_normal;
-        hit.material = &material;
+        hit.object = this;
+        hit.prim_idx = prim_idx;
+        hit.barycentrics = make_float2(v, w);
     }
 
     return intersects;
 }
 
+void Triangle::compute_hit_attributes(const Ray& r, HitInfo& hit) const
+{
+    float v = hit.barycentrics.x;
+    float w = hit.barycentrics.y;
+    hit.position = r.origin + r.direction*hit.dist;
+    hit.geometric_normal = normalize(compute_normal());
+    hit.shading_normal = hit.geometric_normal;
+    hit.texcoord = (1.0f - v - w)*t0 + v*t1 + w*t2;
+    compute_texcoord_differentials(r, hit, v0, v1, v2, make_float2(t0), make_float2(t1), make_float2(t2));
+    hit.material = &material;
+}
+
 void Triangle::transform(const Matrix4x4& m)
 {
     v0 = make_float3(m*make_float4(v0, 1.0f));
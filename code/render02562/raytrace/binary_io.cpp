@@ -0,0 +1,94 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <string>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "ObjMaterial.h"
+#include "MappedFile.h"
+#include "fnv_hash.h"
+#include "binary_io.h"
+
+using namespace std;
+
+namespace
+{
+  bool stat_file(const string& filename, SourceInfo& info)
+  {
+    struct stat st;
+    if(stat(filename.c_str(), &st) != 0)
+      return false;
+    info.size = st.st_size;
+    info.mtime = st.st_mtime;
+    return true;
+  }
+
+  // 64-bit FNV-1a hash of the file contents
+  bool hash_file(const string& filename, unsigned long long& hash)
+  {
+    MappedFile file(filename);
+    if(!file.is_open())
+      return false;
+    hash = fnv_hash(file.begin(), file.get_size());
+    return true;
+  }
+}
+
+bool get_source_info(const string& filename, SourceInfo& info)
+{
+  memset(&info, 0, sizeof(info));
+  return stat_file(filename, info) && hash_file(filename, info.hash);
+}
+
+bool is_source_unchanged(const string& filename, const SourceInfo& info)
+{
+  SourceInfo current;
+  if(!stat_file(filename, current) || current.size != info.size)
+    return false;
+  return current.mtime == info.mtime || (hash_file(filename, current.hash) && current.hash == info.hash);
+}
+
+void read_material(BinaryReader& in, ObjMaterial& m)
+{
+  m.name = in.read_string();
+  in.read(m.diffuse, sizeof(m.diffuse));
+  in.read(m.ambient, sizeof(m.ambient));
+  in.read(m.specular, sizeof(m.specular));
+  m.shininess = in.read<float>();
+  m.ior = in.read<float>();
+  in.read(m.transmission, sizeof(m.transmission));
+  m.illum = in.read<int>();
+  m.has_texture = in.read<unsigned char>() != 0;
+  m.tex_path = in.read_string();
+  m.tex_name = in.read_string();
+}
+
+void write_material(FILE* out, const ObjMaterial& m)
+{
+  write_string(out, m.name);
+  write_bytes(out, m.diffuse, sizeof(m.diffuse));
+  write_bytes(out, m.ambient, sizeof(m.ambient));
+  write_bytes(out, m.specular, sizeof(m.specular));
+  write_value(out, m.shininess);
+  write_value(out, m.ior);
+  write_bytes(out, m.transmission, sizeof(m.transmission));
+  write_value(out, m.illum);
+  write_value(out, static_cast<unsigned char>(m.has_texture));
+  write_string(out, m.tex_path);
+  write_string(out, m.tex_name);
+}
+
+bool commit_file(FILE* out, const string& tmp_file, const string& filename)
+{
+  bool ok = ferror(out) == 0;
+  ok = fclose(out) == 0 && ok;
+  remove(filename.c_str());
+  if(!ok || rename(tmp_file.c_str(), filename.c_str()) != 0)
+  {
+    remove(tmp_file.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,127 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include "ObjMaterial.h"
+
+/// Size, time stamp, and hash of a source file that a binary file was made from
+struct SourceInfo
+{
+  unsigned long long size;
+  long long mtime;
+  unsigned long long hash;
+};
+
+/// Get size, time stamp, and content hash of a file
+bool get_source_info(const std::string& filename, SourceInfo& info);
+
+/// A source is unchanged if size and time stamp match. If only the time
+/// stamp differs, the contents are compared by hash.
+bool is_source_unchanged(const std::string& filename, const SourceInfo& info);
+
+/// Sequential reader of a mapped binary file that fails on overruns
+class BinaryReader
+{
+public:
+  BinaryReader(const char* b, const char* e) : p(b), end(e), ok(true) { }
+
+  bool good() const { return ok; }
+  bool at_end() const { return p == end; }
+  const char* position() const { return p; }
+
+  void read(void* dest, size_t bytes)
+  {
+    if(!ok || static_cast<size_t>(end - p) < bytes)
+    {
+      ok = false;
+      return;
+    }
+    memcpy(dest, p, bytes);
+    p += bytes;
+  }
+
+  template<class T> T read()
+  {
+    T value = T();
+    read(&value, sizeof(T));
+    return value;
+  }
+
+  std::string read_string()
+  {
+    unsigned int length = read<unsigned int>();
+    if(!ok || static_cast<size_t>(end - p) < length)
+    {
+      ok = false;
+      return std::string();
+    }
+    std::string s(p, length);
+    p += length;
+    return s;
+  }
+
+  /// Returns a pointer into the mapped file for n elements of type T
+  template<class T> const T* view(unsigned int n)
+  {
+    size_t bytes = n*sizeof(T);
+    if(!ok || static_cast<size_t>(end - p) < bytes)
+    {
+      ok = false;
+      return 0;
+    }
+    const T* data = reinterpret_cast<const T*>(p);
+    p += bytes;
+    return data;
+  }
+
+  template<class T> void read_vector(std::vector<T>& v)
+  {
+    unsigned int n = read<unsigned int>();
+    const T* data = view<T>(n);
+    if(ok)
+      v.assign(data, data + n);
+  }
+
+private:
+  const char* p;
+  const char* end;
+  bool ok;
+};
+
+void read_material(BinaryReader& in, ObjMaterial& m);
+
+inline void write_bytes(FILE* out, const void* data, size_t bytes) 
+{
+  if(bytes > 0) 
+    fwrite(data, 1, bytes, out); 
+}
+
+template<class T> void write_value(FILE* out, const T& value) { fwrite(&value, sizeof(T), 1, out); }
+
+inline void write_string(FILE* out, const std::string& s)
+{
+  write_value(out, static_cast<unsigned int>(s.size()));
+  write_bytes(out, s.data(), s.size());
+}
+
+template<class T> void write_vector(FILE* out, const std::vector<T>& v)
+{
+  write_value(out, static_cast<unsigned int>(v.size()));
+  if(!v.empty())
+    write_bytes(out, &v[0], v.size()*sizeof(T));
+}
+
+void write_material(FILE* out, const ObjMaterial& m);
+
+/// Close a file written under the name tmp_file and move it to filename.
+/// Returns false and removes the temporary file if anything failed.
+bool commit_file(FILE* out, const std::string& tmp_file, const std::string& filename);
+
+#endif // BINARY_IO_H
@@ -0,0 +1,23 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef FNV_HASH_H
+#define FNV_HASH_H
+
+#include <cstddef>
+
+/// 64-bit FNV-1a hash of a block of memory. Pass the hash of the
+/// previous block to hash several blocks as one.
+inline unsigned long long fnv_hash(const void* data, size_t bytes, unsigned long long hash = 14695981039346656037ULL)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  for(size_t i = 0; i < bytes; ++i)
+  {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+#endif // FNV_HASH_H
@@ -0,0 +1,132 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "binary_io.h"
+#include "hdr_io.h"
+
+using namespace std;
+
+namespace
+{
+  bool is_little_endian()
+  {
+    unsigned int one = 1;
+    return *reinterpret_cast<unsigned char*>(&one) == 1;
+  }
+
+  bool channel_less(const ImageChannel& a, const ImageChannel& b) { return a.name < b.name; }
+
+  void write_attribute(FILE* out, const char* name, const char* type, int size)
+  {
+    write_bytes(out, name, strlen(name) + 1);
+    write_bytes(out, type, strlen(type) + 1);
+    write_value(out, size);
+  }
+}
+
+bool write_pfm(const string& filename, const float* data, unsigned int width, unsigned int height, 
+               unsigned int channels, unsigned int stride)
+{
+  if(channels != 1 && channels != 3)
+    return false;
+  if(stride == 0)
+    stride = channels;
+
+  string tmp_file = filename + ".tmp";
+  FILE* out = fopen(tmp_file.c_str(), "wb");
+  if(!out)
+    return false;
+
+  // A negative scale means little endian floats. Rows go from bottom to top.
+  fprintf(out, "%s\n%u %u\n%s\n", channels == 3 ? "PF" : "Pf", width, height, is_little_endian() ? "-1.0" : "1.0");
+  vector<float> row(width*channels);
+  for(unsigned int y = 0; y < height; ++y)
+  {
+    const float* src = data + static_cast<size_t>(y)*width*stride;
+    for(unsigned int x = 0; x < width; ++x)
+      for(unsigned int c = 0; c < channels; ++c)
+        row[x*channels + c] = src[x*stride + c];
+    write_bytes(out, &row[0], row.size()*sizeof(float));
+  }
+  return commit_file(out, tmp_file, filename);
+}
+
+bool write_exr(const string& filename, const vector<ImageChannel>& channels, unsigned int width, unsigned int height)
+{
+  // OpenEXR is little endian. Here, we write the values as they are in memory.
+  if(channels.empty() || width == 0 || height == 0 || !is_little_endian())
+    return false;
+  vector<ImageChannel> sorted(channels);
+  stable_sort(sorted.begin(), sorted.end(), channel_less);
+
+  string tmp_file = filename + ".tmp";
+  FILE* out = fopen(tmp_file.c_str(), "wb");
+  if(!out)
+    return false;
+
+  // Magic number and version 2 (single part scan line file)
+  write_value(out, 20000630);
+  write_value(out, 2);
+
+  // Header attributes (those required by the format)
+  int chlist_size = 1;
+  for(unsigned int i = 0; i < sorted.size(); ++i)
+    chlist_size += sorted[i].name.size() + 1 + 16;
+  write_attribute(out, "channels", "chlist", chlist_size);
+  for(unsigned int i = 0; i < sorted.size(); ++i)
+  {
+    const unsigned char linear_and_reserved[4] = { 0, 0, 0, 0 };
+    write_bytes(out, sorted[i].name.c_str(), sorted[i].name.size() + 1);
+    write_value(out, 2);                       // Pixel type FLOAT
+    write_bytes(out, linear_and_reserved, 4);
+    write_value(out, 1);                       // x sampling
+    write_value(out, 1);                       // y sampling
+  }
+  write_value(out, '\0');
+
+  const int window[4] = { 0, 0, static_cast<int>(width) - 1, static_cast<int>(height) - 1 };
+  write_attribute(out, "compression", "compression", 1);
+  write_value(out, '\0');                      // No compression
+  write_attribute(out, "dataWindow", "box2i", 16);
+  write_bytes(out, window, 16);
+  write_attribute(out, "displayWindow", "box2i", 16);
+  write_bytes(out, window, 16);
+  write_attribute(out, "lineOrder", "lineOrder", 1);
+  write_value(out, '\0');                      // Increasing y
+  write_attribute(out, "pixelAspectRatio", "float", 4);
+  write_value(out, 1.0f);
+  const float center[2] = { 0.0f, 0.0f };
+  write_attribute(out, "screenWindowCenter", "v2f", 8);
+  write_bytes(out, center, 8);
+  write_attribute(out, "screenWindowWidth", "float", 4);
+  write_value(out, 1.0f);
+  write_value(out, '\0');
+
+  // Line offset table. Each block holds one scan line of all channels.
+  int line_size = width*sorted.size()*sizeof(float);
+  unsigned long long offset = ftell(out) + height*sizeof(unsigned long long);
+  for(unsigned int y = 0; y < height; ++y, offset += 8 + line_size)
+    write_value(out, offset);
+
+  // Scan lines go from top to bottom, whereas row 0 of the image is the bottom row
+  vector<float> line(width);
+  for(unsigned int y = 0; y < height; ++y)
+  {
+    size_t row = static_cast<size_t>(height - 1 - y)*width;
+    write_value(out, static_cast<int>(y));
+    write_value(out, line_size);
+    for(unsigned int i = 0; i < sorted.size(); ++i)
+    {
+      const ImageChannel& channel = sorted[i];
+      for(unsigned int x = 0; x < width; ++x)
+        line[x] = channel.data[(row + x)*channel.stride];
+      write_bytes(out, &line[0], width*sizeof(float));
+    }
+  }
+  return commit_file(out, tmp_file, filename);
+}
@@ -0,0 +1,36 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef HDR_IO_H
+#define HDR_IO_H
+
+#include <string>
+#include <vector>
+
+/// One float channel of an image stored in an interleaved array. The value 
+/// of pixel (x, y) is data[(y*width + x)*stride], and row 0 is the bottom row.
+struct ImageChannel
+{
+  ImageChannel(const std::string& channel_name, const float* channel_data, unsigned int channel_stride)
+    : name(channel_name), data(channel_data), stride(channel_stride)
+  { }
+
+  std::string name;
+  const float* data;
+  unsigned int stride;
+};
+
+/// Write a Portable Float Map with 1 (Pf) or 3 (PF) channels taken from 
+/// interleaved data with stride floats per pixel (0: stride = channels).
+/// Row 0 is the bottom row as in the render result.
+bool write_pfm(const std::string& filename, const float* data, unsigned int width, unsigned int height, 
+               unsigned int channels, unsigned int stride = 0);
+
+/// Write an uncompressed OpenEXR file with one 32-bit float channel per entry 
+/// of channels. Use the names R, G, B for color and layer prefixes for the 
+/// rest (e.g. albedo.R, N.X, Z). The channel order in the file is sorted.
+bool write_exr(const std::string& filename, const std::vector<ImageChannel>& channels, 
+               unsigned int width, unsigned int height);
+
+#endif // HDR_IO_H
@@ -0,0 +1,137 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <optix_world.h>
+#include "TriMesh.h"
+#include "ObjMaterial.h"
+#include "MappedFile.h"
+#include "binary_io.h"
+#include "mesh_cache.h"
+
+using namespace std;
+using namespace optix;
+
+namespace
+{
+  // Bump the version whenever the layout of the file or the
+  // preprocessing of the mesh changes.
+  const char cache_magic[8] = { '0', '2', '5', '6', '2', 'M', 'S', 'H' };
+  const unsigned int cache_version = 1;
+
+  void read_face_set(BinaryReader& in, IndexedFaceSet& ifs)
+  {
+    unsigned int no_vertices = in.read<unsigned int>();
+    const float3* verts = in.view<float3>(no_vertices);
+    unsigned int no_faces = in.read<unsigned int>();
+    const uint3* faces = in.view<uint3>(no_faces);
+    if(!in.good())
+      return;
+    ifs.assign_vertices(verts, no_vertices);
+    ifs.assign_faces(faces, no_faces);
+  }
+
+  void write_face_set(FILE* out, const IndexedFaceSet& ifs)
+  {
+    write_value(out, ifs.no_vertices());
+    write_bytes(out, ifs.vertex_data(), ifs.no_vertices()*sizeof(float3));
+    write_value(out, ifs.no_faces());
+    write_bytes(out, ifs.face_data(), ifs.no_faces()*sizeof(uint3));
+  }
+}
+
+bool mesh_cache_load(const string& cache_file, const Matrix4x4& transform, TriMesh& mesh)
+{
+  MappedFile file(cache_file);
+  if(!file.is_open())
+    return false;
+  BinaryReader in(file.begin(), file.end());
+
+  // Header
+  char magic[sizeof(cache_magic)];
+  in.read(magic, sizeof(magic));
+  if(!in.good() || memcmp(magic, cache_magic, sizeof(magic)) != 0 || in.read<unsigned int>() != cache_version)
+    return false;
+  float m[16];
+  in.read(m, sizeof(m));
+  if(!in.good() || memcmp(m, transform.getData(), sizeof(m)) != 0)
+    return false;
+
+  // Sources
+  unsigned int no_of_sources = in.read<unsigned int>();
+  for(unsigned int i = 0; i < no_of_sources && in.good(); ++i)
+  {
+    string source = in.read_string();
+    SourceInfo cached = in.read<SourceInfo>();
+    if(!in.good() || !is_source_unchanged(source, cached))
+      return false;
+  }
+
+  // Mesh data goes straight from the mapping into the mesh
+  mesh.name = in.read_string();
+  read_face_set(in, mesh.geometry);
+  read_face_set(in, mesh.normals);
+  read_face_set(in, mesh.texcoords);
+  in.read_vector(mesh.mat_idx);
+  in.read_vector(mesh.tex_idx);
+  unsigned int no_of_materials = in.read<unsigned int>();
+  mesh.materials.resize(in.good() ? no_of_materials : 0);
+  for(unsigned int i = 0; i < mesh.materials.size(); ++i)
+    read_material(in, mesh.materials[i]);
+  in.read_vector(mesh.face_areas);
+  in.read_vector(mesh.face_area_cdf);
+  mesh.surface_area = in.read<float>();
+  if(!in.good() || !in.at_end() || mesh.face_areas.size() != mesh.geometry.no_faces())
+  {
+    // Leave no partly read data behind for the OBJ loader
+    mesh = TriMesh();
+    return false;
+  }
+  mesh.face_area_table.build(mesh.face_areas);
+  return true;
+}
+
+void mesh_cache_save(const string& cache_file, const Matrix4x4& transform, 
+                     const vector<string>& sources, const TriMesh& mesh)
+{
+  // Write to a temporary file first so that an interrupted write
+  // never leaves a truncated cache behind.
+  string tmp_file = cache_file + ".tmp";
+  FILE* out = fopen(tmp_file.c_str(), "wb");
+  if(!out)
+  {
+    cerr << "Could not write mesh cache " << cache_file << endl;
+    return;
+  }
+
+  write_bytes(out, cache_magic, sizeof(cache_magic));
+  write_value(out, cache_version);
+  write_bytes(out, transform.getData(), 16*sizeof(float));
+  write_value(out, static_cast<unsigned int>(sources.size()));
+  for(unsigned int i = 0; i < sources.size(); ++i)
+  {
+    SourceInfo info;
+    get_source_info(sources[i], info);
+    write_string(out, sources[i]);
+    write_value(out, info);
+  }
+
+  write_string(out, mesh.name);
+  write_face_set(out, mesh.geometry);
+  write_face_set(out, mesh.normals);
+  write_face_set(out, mesh.texcoords);
+  write_vector(out, mesh.mat_idx);
+  write_vector(out, mesh.tex_idx);
+  write_value(out, static_cast<unsigned int>(mesh.materials.size()));
+  for(unsigned int i = 0; i < mesh.materials.size(); ++i)
+    write_material(out, mesh.materials[i]);
+  write_vector(out, mesh.face_areas);
+  write_vector(out, mesh.face_area_cdf);
+  write_value(out, mesh.surface_area);
+
+  if(!commit_file(out, tmp_file, cache_file))
+    cerr << "Could not write mesh cache " << cache_file << endl;
+}
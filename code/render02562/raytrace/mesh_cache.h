@@ -0,0 +1,24 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <string>
+#include <vector>
+#include <optix_world.h>
+#include "TriMesh.h"
+
+/// Load a mesh from a binary cache file. Fails if the file is missing or was
+/// written by a different version, with a different transformation, or from
+/// source files that have changed since. The mesh should be empty, and it
+/// is left empty if loading fails.
+bool mesh_cache_load(const std::string& cache_file, const optix::Matrix4x4& transform, TriMesh& mesh);
+
+/// Write a loaded mesh (with normals and areas) to a binary cache file. The
+/// sources are the OBJ and MTL files that the mesh was loaded from.
+void mesh_cache_save(const std::string& cache_file, const optix::Matrix4x4& transform, 
+                     const std::vector<std::string>& sources, const TriMesh& mesh);
+
+#endif // MESH_CACHE_H
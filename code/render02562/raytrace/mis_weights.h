@@ -0,0 +1,33 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef MIS_WEIGHTS_H
+#define MIS_WEIGHTS_H
+
+/// Heuristics for combining samples from several sampling strategies
+enum MisHeuristic { mis_none, mis_balance, mis_power };
+
+/// Balance heuristic weight of a sample drawn with pdf f_pdf (nf samples)
+/// when the other strategy has pdf g_pdf (ng samples)
+inline float balance_heuristic(int nf, float f_pdf, int ng, float g_pdf)
+{
+  float f = nf*f_pdf;
+  float g = ng*g_pdf;
+  return f + g > 0.0f ? f/(f + g) : 0.0f;
+}
+
+/// Power heuristic weight (exponent 2) of a sample drawn with pdf f_pdf
+inline float power_heuristic(int nf, float f_pdf, int ng, float g_pdf)
+{
+  float f = nf*f_pdf;
+  float g = ng*g_pdf;
+  return f + g > 0.0f ? f*f/(f*f + g*g) : 0.0f;
+}
+
+inline float mis_weight(MisHeuristic heuristic, float f_pdf, float g_pdf)
+{
+  return heuristic == mis_power ? power_heuristic(1, f_pdf, 1, g_pdf) : balance_heuristic(1, f_pdf, 1, g_pdf);
+}
+
+#endif // MIS_WEIGHTS_H
@@ -6,10 +6,17 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 #include <optix_world.h>
 #include "TriMesh.h"
 #include "ObjMaterial.h"
+#include "MappedFile.h"
+#include "obj_load.h"
 
 using namespace std;
 using namespace optix;
@@ -32,40 +39,324 @@ namespace
 		pathname.append("/");
 		return pathname;
 	}
+
+	inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+	inline const char* skip_blanks(const char* p, const char* end)
+	{
+		while(p < end && is_blank(*p))
+			++p;
+		return p;
+	}
+
+	inline const char* skip_line(const char* p, const char* end)
+	{
+		const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+		return eol ? eol + 1 : end;
+	}
+
+	string read_token(const char*& p, const char* end)
+	{
+		p = skip_blanks(p, end);
+		const char* token = p;
+		while(p < end && !is_blank(*p) && *p != '\n')
+			++p;
+		return string(token, p);
+	}
+
+	bool parse_int(const char*& p, const char* end, int& i)
+	{
+		const char* q = p;
+		bool negative = q < end && *q == '-';
+		if(q < end && (*q == '-' || *q == '+'))
+			++q;
+		if(q == end || !is_digit(*q))
+			return false;
+		int value = 0;
+		while(q < end && is_digit(*q))
+			value = value*10 + (*q++ - '0');
+		i = negative ? -value : value;
+		p = q;
+		return true;
+	}
+
+	// Parses a decimal number with correct rounding like strtof(...). Numbers
+	// with at most 15 significant digits and a small exponent are exactly
+	// representable as a mantissa and a power of ten in double precision,
+	// so one correctly rounded double operation gives the result. Other
+	// numbers are handed to strtof(...).
+	bool parse_float(const char*& p, const char* end, float& f)
+	{
+		static const double powers_of_ten[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		p = skip_blanks(p, end);
+		const char* q = p;
+		bool negative = q < end && *q == '-';
+		if(q < end && (*q == '-' || *q == '+'))
+			++q;
+
+		unsigned long long mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool any_digits = false;
+		while(q < end && is_digit(*q))
+		{
+			any_digits = true;
+			if(mantissa > 0 || *q != '0')
+			{
+				if(++digits <= 19) mantissa = mantissa*10 + (*q - '0');
+				else ++exponent;
+			}
+			++q;
+		}
+		if(q < end && *q == '.')
+		{
+			++q;
+			while(q < end && is_digit(*q))
+			{
+				any_digits = true;
+				if(mantissa > 0 || *q != '0')
+				{
+					if(++digits <= 19)
+					{
+						mantissa = mantissa*10 + (*q - '0');
+						--exponent;
+					}
+				}
+				else
+					--exponent;
+				++q;
+			}
+		}
+		if(any_digits && q < end && (*q == 'e' || *q == 'E'))
+		{
+			const char* e = q + 1;
+			int exp_value;
+			if(parse_int(e, end, exp_value))
+			{
+				exponent += exp_value;
+				q = e;
+			}
+		}
+
+		bool fast = any_digits && digits <= 15 && exponent >= -22 && exponent <= 22
+		            && (q == end || is_blank(*q) || *q == '\n');
+		if(fast)
+		{
+			double d = static_cast<double>(mantissa);
+			d = exponent < 0 ? d/powers_of_ten[-exponent] : d*powers_of_ten[exponent];
+
+			// Rounding to double before rounding to float only changes the
+			// result if the double lies exactly halfway between two floats.
+			unsigned long long bits;
+			memcpy(&bits, &d, sizeof(d));
+			if((bits & 0x1fffffffULL) != 0x10000000ULL)
+			{
+				f = static_cast<float>(negative ? -d : d);
+				p = q;
+				return true;
+			}
+		}
+
+		// Slow path: copy the token and let the C library parse it
+		q = p;
+		while(q < end && !is_blank(*q) && *q != '\n')
+			++q;
+		string token(p, q);
+		char* token_end;
+		float value = strtof(token.c_str(), &token_end);
+		if(token_end == token.c_str())
+			return false;
+		f = value;
+		p += token_end - token.c_str();
+		return true;
+	}
+
+	// Parses a face vertex of the form v, v//n, v/t, or v/t/n
+	bool parse_face_vertex(const char*& p, const char* end, int& v, int& t, int& n, bool& has_t, bool& has_n)
+	{
+		const char* q = skip_blanks(p, end);
+		if(!parse_int(q, end, v))
+			return false;
+		has_t = has_n = false;
+		if(q < end && *q == '/')
+		{
+			++q;
+			has_t = parse_int(q, end, t);
+			if(q < end && *q == '/')
+			{
+				++q;
+				has_n = parse_int(q, end, n);
+			}
+		}
+		p = q;
+		return true;
+	}
+
+	// Data parsed from a line-aligned part of an OBJ file. Faces keep the
+	// indices as written in the file together with the number of vertices
+	// preceding them in the part, so that relative indices can be resolved
+	// once the vertex counts of all preceding parts are known.
+	struct ObjChunk
+	{
+		struct Face
+		{
+			unsigned int first_corner, no_corners;
+			unsigned int no_verts, no_normals, no_texcoords;
+			bool has_texcoords, has_normals;
+		};
+
+		// mtllib and usemtl statements in file order
+		struct Statement
+		{
+			bool is_library;
+			string name;
+			unsigned int first_face;
+		};
+
+		vector<float3> verts, normals, texcoords;
+		vector<int3> corners;
+		vector<Face> faces;
+		vector<Statement> statements;
+	};
+
+	void parse_chunk(const char* p, const char* end, ObjChunk& chunk)
+	{
+		float3 v_geo = make_float3(0.0f);
+		float3 v_normals = make_float3(0.0f);
+		float3 v_texcoords = make_float3(0.0f);
+		while(p < end)
+			{
+				p = skip_blanks(p, end);
+				const char* key = p;
+				while(p < end && !is_blank(*p) && *p != '\n')
+					++p;
+				unsigned int key_length = p - key;
+				if(key_length == 0)
+					{
+						p = skip_line(p, end);
+						continue;
+					}
+				switch(key[0]) 
+					{
+					case 'm': // mtllib
+					case 'u': // usemtl
+						{
+							ObjChunk::Statement statement;
+							statement.is_library = key[0] == 'm';
+							statement.name = read_token(p, end);
+							statement.first_face = chunk.faces.size();
+							chunk.statements.push_back(statement);
+						}
+						break;
+					case 'v': // v, vn, vt
+						if(key_length == 1)
+							{ // vertex
+								parse_float(p, end, v_geo.x);
+								parse_float(p, end, v_geo.y);
+								parse_float(p, end, v_geo.z);
+								chunk.verts.push_back(v_geo);
+							}
+						else if(key_length == 2 && key[1] == 'n')
+							{ // normal
+								parse_float(p, end, v_normals.x);
+								parse_float(p, end, v_normals.y);
+								parse_float(p, end, v_normals.z);
+								chunk.normals.push_back(v_normals);
+							}
+						else if(key_length == 2 && key[1] == 't')
+							{ // texcoord
+								parse_float(p, end, v_texcoords.x);
+								parse_float(p, end, v_texcoords.y);
+								v_texcoords.z=1;
+								chunk.texcoords.push_back(v_texcoords);
+							}
+						break;
+					case 'f':
+						{
+							// Each vertex can be one of v, v//n, v/t, v/t/n. The first vertex
+							// decides the format of the face.
+							ObjChunk::Face face;
+							face.first_corner = chunk.corners.size();
+							face.no_corners = 0;
+							face.no_verts = chunk.verts.size();
+							face.no_normals = chunk.normals.size();
+							face.no_texcoords = chunk.texcoords.size();
+							face.has_texcoords = face.has_normals = false;
+
+							int v, t = 0, n = 0;
+							bool has_t, has_n;
+							while(parse_face_vertex(p, end, v, t, n, has_t, has_n))
+								{
+									if(face.no_corners == 0)
+										{
+											face.has_texcoords = has_t;
+											face.has_normals = has_n;
+										}
+									else if(has_t != face.has_texcoords || has_n != face.has_normals)
+										break;
+									chunk.corners.push_back(make_int3(v, t, n));
+									++face.no_corners;
+								}
+							if(face.no_corners >= 3)
+								chunk.faces.push_back(face);
+							else
+								chunk.corners.resize(face.first_corner);
+						}
+						break;
+					default: // Comments and unsupported keywords
+						break;
+					}
+				p = skip_line(p, end);
+			}
+	}
 }
 
 class TriMeshObjLoader
 {
 	TriMesh *mesh;
 	std::string pathname;
+	std::vector<std::string>* mtl_files;
+	ObjStream* stream;
+	int current_material;
 
-	int get_vert(int i) {
+	// Indices are resolved relative to the number of vertices preceding the face
+
+	int get_vert(int i, unsigned int no_verts) {
 		assert(i!=0);
 		if (i<0) {
-			return mesh->geometry.no_vertices()+i;
+			return no_verts+i;
 		} else
 			return i-1;
 	}
 
-	int get_normal(int i) {
+	int get_normal(int i, unsigned int no_normals) {
 		if (i<0) {
-			return mesh->normals.no_vertices()+i;
+			return no_normals+i;
 		} else
 			return i-1;
 	}
 
-	int get_texcoord(int i) {
+	int get_texcoord(int i, unsigned int no_texcoords) {
 		if (i<0) {
-			return mesh->texcoords.no_vertices()+i;
+			return no_texcoords+i;
 		} else
 			return i-1;
 	}
 
 	void read_material_library(const string& filename, vector<ObjMaterial>& materials);
+	void parse(const char* begin, const char* end);
+	void merge(const vector<ObjChunk>& chunks);
+	void add_triangle(const uint3& f_geo, const uint3& f_texcoords, const uint3& f_normals,
+	                  bool has_texcoords, bool has_normals, int material);
 
 public:
 
-	TriMeshObjLoader(TriMesh *_mesh): mesh(_mesh) {}
+	TriMeshObjLoader(TriMesh *_mesh, std::vector<std::string>* _mtl_files = 0, ObjStream* _stream = 0)
+		: mesh(_mesh), mtl_files(_mtl_files), stream(_stream), current_material(0) {}
 	
 	void load(const std::string& filename);
   void load_material_library(const string& filename, vector<ObjMaterial>& materials)
@@ -78,6 +369,8 @@ public:
 void TriMeshObjLoader::read_material_library(const string& filename, vector<ObjMaterial>& materials)
 {
 	string fn = pathname + filename;
+	if(mtl_files)
+		mtl_files->push_back(fn);
 	FILE* file = fopen(fn.data(), "r");
 	if (!file) 
 		{
@@ -196,198 +489,178 @@ void TriMeshObjLoader::read_material_library(const string& filename, vector<ObjM
 }
 
 
-void TriMeshObjLoader::load(const std::string& filename) 
+void TriMeshObjLoader::add_triangle(const uint3& f_geo, const uint3& f_texcoords, const uint3& f_normals,
+                                    bool has_texcoords, bool has_normals, int material)
 {
-	pathname = get_path(filename);
-	FILE *fp = fopen(filename.data(), "r");
-	if (fp==0) {
-		cerr << "File " << filename << " does not exist" << endl;
-    exit(0);
-	}
-	mesh->materials.resize(1);
-	
-	char buf[256];
-	float3 v_geo;
-	float3 v_normals;
-	float3 v_texcoords;
-
-	uint3 f_geo;
-	uint3 f_normals;
-	uint3 f_texcoords;
-	int current_material=0;
-	int v, n, t;
-	while(fscanf(fp, "%s", buf) != EOF) 
+	int idx = mesh->geometry.add_face(f_geo);
+	if(has_normals)
+		mesh->normals.add_face(f_normals, idx);
+	if(has_texcoords)
+		mesh->texcoords.add_face(f_texcoords, idx);
+	mesh->mat_idx.push_back(material);
+}
+
+void TriMeshObjLoader::merge(const vector<ObjChunk>& chunks)
+{
+	unsigned int no_verts = 0, no_normals = 0, no_texcoords = 0, no_faces = 0;
+	for(unsigned int i = 0; i < chunks.size(); ++i)
 		{
-			switch(buf[0]) 
+			const ObjChunk& chunk = chunks[i];
+			no_verts += chunk.verts.size();
+			no_normals += chunk.normals.size();
+			no_texcoords += chunk.texcoords.size();
+			for(unsigned int j = 0; j < chunk.faces.size(); ++j)
+				no_faces += chunk.faces[j].no_corners - 2;
+		}
+	// Vertices of a streamed file are appended chunk by chunk and are left
+	// to grow by themselves
+	if(!stream)
+		{
+			mesh->geometry.reserve_vertices(no_verts);
+			mesh->normals.reserve_vertices(no_normals);
+			mesh->texcoords.reserve_vertices(no_texcoords);
+		}
+	mesh->geometry.reserve_faces(no_faces);
+	mesh->mat_idx.reserve(no_faces);
+
+	// Relative indices count the vertices of preceding chunks too
+	unsigned int verts_offset = mesh->geometry.no_vertices();
+	unsigned int normals_offset = mesh->normals.no_vertices();
+	unsigned int texcoords_offset = mesh->texcoords.no_vertices();
+	for(unsigned int i = 0; i < chunks.size(); ++i)
+		{
+			const ObjChunk& chunk = chunks[i];
+			for(unsigned int j = 0; j < chunk.verts.size(); ++j)
+				mesh->geometry.add_vertex(chunk.verts[j]);
+			for(unsigned int j = 0; j < chunk.normals.size(); ++j)
+				mesh->normals.add_vertex(chunk.normals[j]);
+			for(unsigned int j = 0; j < chunk.texcoords.size(); ++j)
+				mesh->texcoords.add_vertex(chunk.texcoords[j]);
+		}
+
+	uint3 f_geo = make_uint3(0);
+	uint3 f_normals = make_uint3(0);
+	uint3 f_texcoords = make_uint3(0);
+	for(unsigned int i = 0; i < chunks.size(); ++i)
+		{
+			const ObjChunk& chunk = chunks[i];
+			unsigned int statement = 0;
+			for(unsigned int j = 0; j <= chunk.faces.size(); ++j)
 				{
-				case '#': // A comment
-					fgets(buf, sizeof(buf), fp);
-					break;
-				case 'm':
-					fgets(buf, sizeof(buf), fp);
-					sscanf(buf, "%s %s", buf, buf);
-					read_material_library(buf, mesh->materials);
-					break;
-				case 'u':
-					fgets(buf, sizeof(buf), fp);
-					sscanf(buf, "%s %s", buf, buf);
-					current_material = mesh->find_material(buf);
-					break;
-				case 'v': // v, vn, vt
-					switch(buf[1]) 
+					// Material statements preceding this face
+					for(; statement < chunk.statements.size() && chunk.statements[statement].first_face == j; ++statement)
 						{
-						case '\0': // vertex
-							fscanf(fp, "%f %f %f", &v_geo.x, &v_geo.y, &v_geo.z);
-							mesh->geometry.add_vertex(v_geo);
-							break;
-						case 'n': // normal
-							fscanf(fp, "%f %f %f", &v_normals.x, &v_normals.y, &v_normals.z);
-							mesh->normals.add_vertex(v_normals);
-							break;
-						case 't': // texcoord
-							fscanf(fp, "%f %f", &v_texcoords.x, &v_texcoords.y);
-							v_texcoords.z=1;
-							mesh->texcoords.add_vertex(v_texcoords);
-							break;
+							const ObjChunk::Statement& s = chunk.statements[statement];
+							if(s.is_library)
+								read_material_library(s.name, mesh->materials);
+							else
+								current_material = mesh->find_material(s.name);
 						}
-					break;
-				case 'f':
-					v = n = t = 0;
-					fscanf(fp, "%s", buf);
-					// can be one of %d, %d//%d, %d/%d, %d/%d/%d 
-					if(sscanf(buf, "%d/%d/%d", &v, &t, &n) == 3)
-						{ // v/t/n
-							
-							f_geo.x = get_vert(v); 
-							f_texcoords.x = get_texcoord(t);
-							f_normals.x = get_normal(n);
-
-							fscanf(fp, "%d/%d/%d", &v, &t, &n); 
-							f_geo.y = get_vert(v); 
-							f_texcoords.y = get_texcoord(t);
-							f_normals.y = get_normal(n);
-
-							fscanf(fp, "%d/%d/%d", &v, &t, &n); 
-							f_geo.z = get_vert(v); 
-							f_texcoords.z = get_texcoord(t);
-							f_normals.z = get_normal(n);
-
-							int idx = mesh->geometry.add_face(f_geo);
-							mesh->normals.add_face(f_normals, idx);
-							mesh->texcoords.add_face(f_texcoords, idx);
-							mesh->mat_idx.push_back(current_material);
-
-							// Load a general polygon and convert to triangles
-							while(fscanf(fp, "%d/%d/%d", &v, &t, &n) == 3) 
-								{
-									f_geo.y = f_geo.z;
-									f_normals.y = f_normals.z;
-									f_texcoords.y = f_texcoords.z;
-
-									f_geo.z = get_vert(v);
-									f_normals.z = get_normal(n);
-									f_texcoords.z = get_texcoord(t);
-
-									int idx = mesh->geometry.add_face(f_geo);
-									mesh->normals.add_face(f_normals, idx);
-									mesh->texcoords.add_face(f_texcoords, idx);
-									mesh->mat_idx.push_back(current_material);
-								}
-						} 
-					else if (sscanf(buf, "%d//%d", &v, &n) == 2)
-						{// v//n 
-							f_geo.x = get_vert(v);
-							f_normals.x = get_normal(n);
-
-							fscanf(fp, "%d//%d", &v, &n); 
-							f_geo.y = get_vert(v);
-							f_normals.y = get_normal(n);
-							
-							fscanf(fp, "%d//%d", &v, &n); 
-							f_geo.z = get_vert(v);
-							f_normals.z = get_normal(n);
-							
-							int idx = mesh->geometry.add_face(f_geo);
-							mesh->normals.add_face(f_normals, idx);
-							mesh->mat_idx.push_back(current_material);
-							
-							// Load a general polygon and convert to triangles
-							while(fscanf(fp, "%d//%d", &v, &n) == 2) 
-								{
-									f_geo.y = f_geo.z;
-									f_normals.y = f_normals.z;
-									f_geo.z = get_vert(v);
-									int idx = mesh->geometry.add_face(f_geo);
-									mesh->normals.add_face(f_normals, idx);
-									mesh->mat_idx.push_back(current_material);
-								}
-						} 
-					else if (sscanf(buf, "%d/%d", &v, &t) == 2)
-						{ // v/t 
-							f_geo.x = get_vert(v);
-							f_texcoords.x = get_texcoord(t);
-
-							fscanf(fp, "%d/%d", &v, &t); 
-							f_geo.y = get_vert(v);
-							f_texcoords.y = get_texcoord(t);
-
-							fscanf(fp, "%d/%d", &v, &t); 
-							f_geo.z = get_vert(v);
-							f_texcoords.z = get_texcoord(t);
-
-							int idx = mesh->geometry.add_face(f_geo);
-							mesh->texcoords.add_face(f_texcoords, idx);
-							mesh->mat_idx.push_back(current_material);
-					
-							// Load a general polygon and convert to triangles
-							while(fscanf(fp, "%d/%d", &v, &t)==2) 
-								{
-									f_geo.y = f_geo.z;
-									f_texcoords.y = f_texcoords.z;
-							
-									f_geo.z = get_vert(v);
-									f_texcoords.z = get_texcoord(t);
-
-									int idx = mesh->geometry.add_face(f_geo);
-									mesh->texcoords.add_face(f_texcoords, idx);
-									mesh->mat_idx.push_back(current_material);
-								}
-						} 
-					else if (sscanf(buf, "%d", &v)==1)
-						{ // v 
-							f_geo.x = get_vert(v);
-							
-							fscanf(fp, "%d", &v);
-							f_geo.y = get_vert(v);
-							
-							fscanf(fp, "%d", &v);
-							f_geo.z = get_vert(v);
-							
-							mesh->geometry.add_face(f_geo);
-							mesh->mat_idx.push_back(current_material);
-
-							// Load a general polygon and convert to triangles
-							while(fscanf(fp, "%d", &v)==1) 
+					if(j == chunk.faces.size())
+						break;
+
+					// A general polygon is converted to a fan of triangles
+					const ObjChunk::Face& face = chunk.faces[j];
+					unsigned int no_verts = verts_offset + face.no_verts;
+					unsigned int no_normals = normals_offset + face.no_normals;
+					unsigned int no_texcoords = texcoords_offset + face.no_texcoords;
+					for(unsigned int k = 0; k < face.no_corners; ++k)
+						{
+							const int3& corner = chunk.corners[face.first_corner + k];
+							if(k == 0)
 								{
-									f_geo.y = f_geo.z;
-									f_geo.z = get_vert(v);
-									mesh->geometry.add_face(f_geo);
-									mesh->mat_idx.push_back(current_material);
+									f_geo.x = get_vert(corner.x, no_verts);
+									if(face.has_texcoords) f_texcoords.x = get_texcoord(corner.y, no_texcoords);
+									if(face.has_normals) f_normals.x = get_normal(corner.z, no_normals);
+									continue;
 								}
+							f_geo.y = f_geo.z;
+							f_texcoords.y = f_texcoords.z;
+							f_normals.y = f_normals.z;
+
+							f_geo.z = get_vert(corner.x, no_verts);
+							if(face.has_texcoords) f_texcoords.z = get_texcoord(corner.y, no_texcoords);
+							if(face.has_normals) f_normals.z = get_normal(corner.z, no_normals);
+
+							if(k > 1)
+								add_triangle(f_geo, f_texcoords, f_normals, face.has_texcoords, face.has_normals, current_material);
 						}
-					break;
-				default:
-					fgets(buf, sizeof(buf), fp);
-					break;
 				}
+			verts_offset += chunk.verts.size();
+			normals_offset += chunk.normals.size();
+			texcoords_offset += chunk.texcoords.size();
+		}
+}
+
+void TriMeshObjLoader::load(const std::string& filename) 
+{
+	pathname = get_path(filename);
+	MappedFile file(filename);
+	if(!file.is_open()) {
+		cerr << "File " << filename << " does not exist" << endl;
+    exit(0);
+	}
+	mesh->materials.resize(1);
+	current_material = 0;
+
+	// A streamed file is parsed in line-aligned windows, and the triangles
+	// of a window are handed over before the next one is parsed
+	const size_t stream_window_size = 1 << 25;
+	const char* begin = file.begin();
+	const char* end = file.end();
+	if(!stream)
+		{
+			parse(begin, end);
+			return;
 		}
-  fclose(fp);
+	while(begin < end)
+		{
+			const char* window_end = skip_line(begin + std::min<size_t>(stream_window_size, end - begin) - 1, end);
+			parse(begin, window_end);
+			stream->add_triangles(*mesh);
+			mesh->geometry.clear_faces();
+			mesh->normals.clear_faces();
+			mesh->texcoords.clear_faces();
+			mesh->mat_idx.clear();
+			begin = window_end;
+		}
+}
+
+void TriMeshObjLoader::parse(const char* begin, const char* end)
+{
+	// Split the text into line-aligned chunks that are parsed in parallel.
+	// Small texts are parsed as a single chunk.
+	const size_t min_chunk_size = 1 << 22;
+	size_t size = end - begin;
+	int no_of_chunks = 1;
+#ifdef _OPENMP
+	no_of_chunks = omp_get_max_threads();
+#endif
+	no_of_chunks = static_cast<int>(std::max<size_t>(1, std::min<size_t>(no_of_chunks, size/min_chunk_size)));
+
+	vector<const char*> bounds(no_of_chunks + 1, end);
+	bounds[0] = begin;
+	for(int i = 1; i < no_of_chunks; ++i)
+		bounds[i] = std::max(bounds[i - 1], skip_line(begin + size*i/no_of_chunks - 1, end));
+
+	vector<ObjChunk> chunks(no_of_chunks);
+	#pragma omp parallel for schedule(dynamic)
+	for(int i = 0; i < no_of_chunks; ++i)
+		parse_chunk(bounds[i], bounds[i + 1], chunks[i]);
+
+	merge(chunks);
 }
 
 
-void obj_load(const string& filename, TriMesh& mesh)
+void obj_load(const string& filename, TriMesh& mesh, vector<string>* mtl_files)
+{
+	TriMeshObjLoader loader(&mesh, mtl_files);
+	loader.load(filename);
+}
+
+void obj_stream(const string& filename, TriMesh& mesh, ObjStream& stream, vector<string>* mtl_files)
 {
-	TriMeshObjLoader loader(&mesh);
+	TriMeshObjLoader loader(&mesh, mtl_files, &stream);
 	loader.load(filename);
 }
 
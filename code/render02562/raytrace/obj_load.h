@@ -10,8 +10,25 @@
 #include "ObjMaterial.h"
 #include "TriMesh.h"
 
-/// Load a TriMesh from an OBJ file
-void obj_load(const std::string &filename, TriMesh &mesh);
+/// Load a TriMesh from an OBJ file. If mtl_files is given, the paths of
+/// the material libraries used by the OBJ file are appended to it.
+void obj_load(const std::string &filename, TriMesh &mesh, std::vector<std::string>* mtl_files = 0);
+
+/// Receiver of the triangles of an OBJ file that is loaded in chunks
+class ObjStream
+{
+public:
+  virtual ~ObjStream() { }
+
+  /// Called once per chunk of the file. The mesh holds all vertices and
+  /// materials read so far, but only the triangles of the current chunk.
+  virtual void add_triangles(const TriMesh& mesh) = 0;
+};
+
+/// Load an OBJ file in chunks of lines, so that only the vertices and the
+/// triangles of one chunk are kept in memory. When done, the mesh holds
+/// all vertices and materials but no triangles.
+void obj_stream(const std::string &filename, TriMesh &mesh, ObjStream& stream, std::vector<std::string>* mtl_files = 0);
 
 /// Load materials from an MTL file
 void mtl_load(const std::string& filename, std::vector<ObjMaterial>& materials);
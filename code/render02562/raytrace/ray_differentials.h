@@ -0,0 +1,57 @@
+// 02562 Rendering Framework
+// Written by Jeppe Revall Frisvad, 2011
+// Copyright (c) DTU Informatics 2011
+
+#ifndef RAY_DIFFERENTIALS_H
+#define RAY_DIFFERENTIALS_H
+
+#include <optix_world.h>
+#include "HitInfo.h"
+
+// Ray differentials as described by Igehy [1999]. The differentials of the
+// ray origin and direction with respect to image plane x and y are stored in
+// the hit info before tracing. At the hit, they are transferred to the
+// surface and converted to texture coordinate differentials, which give
+// the footprint for filtered texture look-ups.
+
+/// Position differentials at the hit point of a surface with the given normal
+inline void transfer_ray_differentials(const optix::Ray& r, const HitInfo& hit, const optix::float3& normal, 
+                                       optix::float3& dpdx, optix::float3& dpdy)
+{
+  float cos_theta = optix::dot(r.direction, normal);
+  dpdx = hit.dodx + hit.dist*hit.dddx;
+  dpdy = hit.dody + hit.dist*hit.dddy;
+  if(cos_theta != 0.0f)
+  {
+    dpdx -= r.direction*(optix::dot(dpdx, normal)/cos_theta);
+    dpdy -= r.direction*(optix::dot(dpdy, normal)/cos_theta);
+  }
+}
+
+/// Texture coordinate differentials at the hit point of a triangle
+inline void compute_texcoord_differentials(const optix::Ray& r, HitInfo& hit,
+                                           const optix::float3& v0, const optix::float3& v1, const optix::float3& v2,
+                                           const optix::float2& t0, const optix::float2& t1, const optix::float2& t2)
+{
+  if(!hit.has_differentials)
+    return;
+
+  optix::float3 e1 = v1 - v0;
+  optix::float3 e2 = v2 - v0;
+  optix::float3 n = optix::cross(e1, e2);
+  float n_sqr = optix::dot(n, n);
+  if(n_sqr == 0.0f)
+    return;
+  optix::float3 dpdx, dpdy;
+  transfer_ray_differentials(r, hit, n, dpdx, dpdy);
+
+  // Barycentric coordinate differentials from dp = dv*e1 + dw*e2
+  float dvdx = optix::dot(optix::cross(dpdx, e2), n)/n_sqr;
+  float dwdx = optix::dot(optix::cross(e1, dpdx), n)/n_sqr;
+  float dvdy = optix::dot(optix::cross(dpdy, e2), n)/n_sqr;
+  float dwdy = optix::dot(optix::cross(e1, dpdy), n)/n_sqr;
+  hit.texcoord_dx = dvdx*(t1 - t0) + dwdx*(t2 - t0);
+  hit.texcoord_dy = dvdy*(t1 - t0) + dwdy*(t2 - t0);
+}
+
+#endif // RAY_DIFFERENTIALS_H
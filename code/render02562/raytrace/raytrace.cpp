@@ -6,9 +6,17 @@
 
 int main(int argc, char** argv)
 {
-  render_engine.init_GLUT(argc, argv);
   render_engine.load_files(argc, argv);
 
+  // Sequences are rendered straight to files without a window
+  if(render_engine.has_sequence())
+  {
+    render_engine.init_tracer();
+    render_engine.render_sequence();
+    return 0;
+  }
+
+  render_engine.init_GLUT(argc, argv);
   render_engine.init_GL();
   render_engine.init_texture();
   render_engine.init_tracer();